@@ -0,0 +1,268 @@
+// Times the batch routines against their slower or single threaded
+// versions, away from the projects' render loops. Build from Project3F19,
+// with every source there but main.cpp and Window.cpp; nothing is drawn, so
+// no window or context is needed:
+//
+//   g++ -std=c++17 -O2 -I. -o benchmark ../Benchmarks/Benchmark.cpp [!mW]*.cpp ../Common/*.cpp
+//       -lGLEW -lGL -lpthread
+//   ./benchmark [culling|scene|cubic]
+//
+// With no argument every benchmark runs.
+
+#include "../Common/SphereCuller.h"
+#include "../Common/Frustum.h"
+#include "../Common/JobSystem.h"
+#include "../Common/CubicBatch.h"
+#include "../Project3F19/Scene.h"
+#include "../Project3F19/Transform.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    double elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Scalar against SIMD culling of count random spheres, with Project 3's
+    // starting camera.
+    void benchmarkSphereCulling(size_t count)
+    {
+        glm::mat4 projection = glm::perspective(glm::radians(60.0), 640.0 / 480.0, 1.0, 1000.0);
+        glm::mat4 view = glm::lookAt(glm::vec3(225, 50, 225), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+        glm::vec4 planes[6];
+        extractFrustumPlanes(projection * view, planes);
+
+        // The same spheres every run: centers in a 2000 unit cube around the
+        // origin, radii up to 25.
+        SphereSet spheres;
+        uint32_t state = 12345;
+        auto random = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return (float)(state >> 8) / (float)(1 << 24);
+        };
+        for (size_t i = 0; i < count; i++)
+        {
+            glm::vec3 center(random() * 2000.0f - 1000.0f, random() * 2000.0f - 1000.0f, random() * 2000.0f - 1000.0f);
+            spheres.push(center, 1.0f + random() * 24.0f);
+        }
+
+        const int runs = 20;
+        std::vector<uint32_t> reference;
+        double scalarTime = 0.0;
+        SimdPath paths[] = { SIMD_PATH_SCALAR, SIMD_PATH_SSE, SIMD_PATH_AVX2 };
+        for (SimdPath path : paths)
+        {
+            if (path > bestSimdPath())
+            {
+                break;
+            }
+
+            std::vector<uint32_t> visible;
+            cullSpheres(planes, spheres, visible, path);
+            auto start = std::chrono::steady_clock::now();
+            for (int run = 0; run < runs; run++)
+            {
+                cullSpheres(planes, spheres, visible, path);
+            }
+            double time = elapsedMs(start) / runs;
+
+            size_t visibleCount = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                visibleCount += isVisible(visible, i);
+            }
+            if (path == SIMD_PATH_SCALAR)
+            {
+                reference = visible;
+                scalarTime = time;
+            }
+            printf("Culled %zu spheres with %s: %.3f ms (%.2fx scalar), %zu visible%s\n", count, simdPathName(path),
+                   time, time > 0.0 ? scalarTime / time : 0.0, visibleCount,
+                   visible == reference ? "" : ", DIFFERENT from scalar");
+        }
+    }
+
+    // Stands in for a robot part's mesh: only its bounds, a box of the given
+    // half extents, matter to the scene.
+    class Part : public Node
+    {
+    private:
+        Bounds bounds;
+    public:
+        Part(const glm::vec3& extent)
+        {
+            glm::vec3 corners[2] = { -extent, extent };
+            bounds = computeBounds(corners, 2);
+        }
+        void draw(const glm::mat4& C, DrawContext& context, int lod) {}
+        Bounds getBounds() { return bounds; }
+    };
+
+    // The robot of Project 3's Window::initializeObjects, parts and
+    // animation, without the meshes.
+    Transform* buildRobot()
+    {
+        Transform* robot = new Transform(glm::mat4(1.0), -1, 1);
+        Transform* body = new Transform(glm::mat4(1.0));
+        Transform* head = new Transform(glm::translate(glm::vec3(0, 11.25, 0)));
+        Transform* leftEye = new Transform(glm::translate(glm::vec3(2.5, -1, 6.5)) * glm::scale(glm::vec3(0.1)));
+        Transform* rightEye = new Transform(glm::translate(glm::vec3(-2.5, -1, 6.5)) * glm::scale(glm::vec3(0.1)));
+        Transform* leftArm = new Transform(glm::translate(glm::vec3(11, 0, 0)) * glm::rotate(glm::radians(10.0f), glm::vec3(0, 0, 1)), -1, 3);
+        Transform* rightArm = new Transform(glm::translate(glm::vec3(-11, 0, 0)) * glm::rotate(-glm::radians(10.0f), glm::vec3(0, 0, 1)), -1, 4);
+        Transform* leftLeg = new Transform(glm::scale(glm::vec3(1, 0.5, 1)) * glm::translate(glm::vec3(4, -23, 0)), -1, 5);
+        Transform* rightLeg = new Transform(glm::scale(glm::vec3(1, 0.5, 1)) * glm::translate(glm::vec3(-4, -23, 0)), -1, 6);
+        leftArm->setMoveDir(1);
+        rightArm->setMoveDir(-1);
+        leftLeg->setMoveDir(-1);
+        rightLeg->setMoveDir(1);
+
+        robot->addChild(body);
+        robot->addChild(head);
+        robot->addChild(leftArm);
+        robot->addChild(rightArm);
+        robot->addChild(leftLeg);
+        robot->addChild(rightLeg);
+        head->addChild(leftEye);
+        head->addChild(rightEye);
+
+        // One Part each, so deleting the robot deletes each once.
+        body->addChild(new Part(glm::vec3(7.5, 10, 5)));
+        head->addChild(new Part(glm::vec3(6, 6, 6)));
+        leftEye->addChild(new Part(glm::vec3(10)));
+        rightEye->addChild(new Part(glm::vec3(10)));
+        leftArm->addChild(new Part(glm::vec3(2.5, 10, 2.5)));
+        rightArm->addChild(new Part(glm::vec3(2.5, 10, 2.5)));
+        leftLeg->addChild(new Part(glm::vec3(2.5, 10, 2.5)));
+        rightLeg->addChild(new Part(glm::vec3(2.5, 10, 2.5)));
+        return robot;
+    }
+
+    // Scene updates of a rows by rows grid of robots across 1 to 8 threads.
+    // Every frame poses every robot and gathers every bounding sphere.
+    void benchmarkSceneUpdate(int rows)
+    {
+        Transform grid(glm::mat4(1.0));
+        Transform* robot = buildRobot();
+        for (int i = 0; i < rows; i++)
+        {
+            for (int j = 0; j < rows; j++)
+            {
+                Transform* cell = new Transform(glm::translate(glm::vec3(50 * i, 0, 50 * j)));
+                cell->addChild(robot);
+                grid.addChild(cell);
+            }
+        }
+        grid.updateBounds();
+        Scene scene;
+        scene.build(&grid);
+        printf("Scene update, %d robots in %zu entries:\n", rows * rows, scene.size());
+
+        const unsigned threadCounts[] = { 1, 2, 4, 8 };
+        const int frames = 100;
+        double single = 0.0;
+        for (unsigned threads : threadCounts)
+        {
+            JobSystem pool(threads);
+            auto start = std::chrono::steady_clock::now();
+            for (int frame = 0; frame < frames; frame++)
+            {
+                scene.boundsChanged();
+                scene.update(frame / 60.0, &pool);
+            }
+            double time = elapsedMs(start) / frames;
+            if (threads == 1)
+            {
+                single = time;
+            }
+            printf("  %u threads: %.3f ms (%.2fx)\n", threads, time, single / time);
+        }
+
+        // The cells share the robot, so it is deleted once, on its own.
+        for (Node* cell : grid.getChildren())
+        {
+            ((Transform*)cell)->removeChild(robot);
+        }
+        delete robot;
+    }
+
+    // pow() per component, as Project 4's curves used to, against Horner's
+    // scheme on every path, over count parameters of a curve with a loop.
+    void benchmarkCubicEvaluation(size_t count)
+    {
+        glm::vec3 p[4] = { glm::vec3(0.0f), glm::vec3(0.0f, 100.0f, 0.0f), glm::vec3(5.0f, -50.0f, 0.0f),
+                           glm::vec3(10.0f, 0.0f, 20.0f) };
+        glm::vec3 coeff[4] = { -p[0] + 3.0f * p[1] - 3.0f * p[2] + p[3], 3.0f * p[0] - 6.0f * p[1] + 3.0f * p[2],
+                               -3.0f * p[0] + 3.0f * p[1], p[0] };
+        std::vector<float> t(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            t[i] = (float)i / (float)(count - 1);
+        }
+        std::vector<float> x(count), y(count), z(count);
+        const int runs = 20;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int run = 0; run < runs; run++)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                glm::vec3 point = coeff[0] * std::pow(t[i], 3.0f) + coeff[1] * std::pow(t[i], 2.0f) + coeff[2] * t[i] + coeff[3];
+                x[i] = point.x;
+                y[i] = point.y;
+                z[i] = point.z;
+            }
+        }
+        double powTime = elapsedMs(start) / runs;
+        printf("Evaluated %zu points with pow: %.3f ms\n", count, powTime);
+        std::vector<float> reference = y;
+
+        SimdPath paths[] = { SIMD_PATH_SCALAR, SIMD_PATH_SSE, SIMD_PATH_AVX2 };
+        for (SimdPath path : paths)
+        {
+            if (path > bestSimdPath())
+            {
+                break;
+            }
+            start = std::chrono::steady_clock::now();
+            for (int run = 0; run < runs; run++)
+            {
+                evaluateCubicPoints(coeff, t.data(), count, x.data(), y.data(), z.data(), path);
+            }
+            double time = elapsedMs(start) / runs;
+
+            float error = 0.0f;
+            for (size_t i = 0; i < count; i++)
+            {
+                error = std::fmax(error, std::fabs(y[i] - reference[i]));
+            }
+            printf("Evaluated %zu points with Horner, %s: %.3f ms (%.2fx pow), largest difference %g\n", count,
+                   simdPathName(path), time, time > 0.0 ? powTime / time : 0.0, error);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    if (!only || strcmp(only, "culling") == 0)
+    {
+        benchmarkSphereCulling(1000000);
+    }
+    if (!only || strcmp(only, "scene") == 0)
+    {
+        benchmarkSceneUpdate(100);
+    }
+    if (!only || strcmp(only, "cubic") == 0)
+    {
+        benchmarkCubicEvaluation(1000000);
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "AsyncMeshLoader.h"
+
+MeshLoadRequest::MeshLoadRequest(const std::string& filename, MeshLayout layout, float radius,
+                                 bool optimize, VertexFormat format)
+    : filename(filename), layout(layout), radius(radius), optimize(optimize), format(format),
+      current(LOADING)
+{
+}
+
+void MeshLoadRequest::run()
+{
+    bool loaded = mesh.load(filename, layout, radius, optimize);
+    if (loaded)
+    {
+        packVertices(mesh, format, vertices);
+    }
+    current.store(loaded ? LOADED : FAILED, std::memory_order_release);
+}
+
+AsyncMeshLoader::AsyncMeshLoader(unsigned threadCount)
+    : stopping(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+    for (unsigned i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&AsyncMeshLoader::work, this);
+    }
+}
+
+AsyncMeshLoader::~AsyncMeshLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+        queue.clear();
+    }
+    queueReady.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+std::shared_ptr<MeshLoadRequest> AsyncMeshLoader::load(const std::string& filename,
+                                                       MeshLayout layout, float radius, bool optimize,
+                                                       VertexFormat format)
+{
+    std::shared_ptr<MeshLoadRequest> request =
+        std::make_shared<MeshLoadRequest>(filename, layout, radius, optimize, format);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(request);
+    }
+    queueReady.notify_one();
+    return request;
+}
+
+void AsyncMeshLoader::work()
+{
+    while (true)
+    {
+        std::shared_ptr<MeshLoadRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            request = queue.front();
+            queue.pop_front();
+        }
+        request->run();
+    }
+}
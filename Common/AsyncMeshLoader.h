@@ -0,0 +1,70 @@
+#ifndef _ASYNC_MESH_LOADER_H_
+#define _ASYNC_MESH_LOADER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MeshCache.h"
+#include "VertexFormat.h"
+
+// One mesh being loaded in the background. The worker fills in mesh and
+// vertices (packed for format) and then publishes the new state; other
+// threads may only touch mesh once state() is no longer LOADING.
+class MeshLoadRequest
+{
+public:
+    enum State
+    {
+        LOADING,
+        LOADED,
+        FAILED
+    };
+
+    std::string filename;
+    MeshLayout layout;
+    float radius;
+    bool optimize;
+    VertexFormat format;
+    MeshCache mesh;
+    PackedVertices vertices;
+
+    MeshLoadRequest(const std::string& filename, MeshLayout layout, float radius,
+                    bool optimize = false, VertexFormat format = VERTEX_FORMAT_SEPARATE);
+    State state() const { return current.load(std::memory_order_acquire); }
+    // Loads on the calling thread.
+    void run();
+private:
+    std::atomic<State> current;
+};
+
+// Parses and normalizes meshes on worker threads so the render thread only
+// has to upload the finished arrays.
+class AsyncMeshLoader
+{
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::shared_ptr<MeshLoadRequest>> queue;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    bool stopping;
+
+    void work();
+public:
+    AsyncMeshLoader(unsigned threadCount = 2);
+    // Requests still in the queue are dropped; ones already running finish.
+    ~AsyncMeshLoader();
+    AsyncMeshLoader(const AsyncMeshLoader&) = delete;
+    AsyncMeshLoader& operator=(const AsyncMeshLoader&) = delete;
+
+    std::shared_ptr<MeshLoadRequest> load(const std::string& filename, MeshLayout layout,
+                                          float radius = 7.5f, bool optimize = false,
+                                          VertexFormat format = VERTEX_FORMAT_SEPARATE);
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "Bounds.h"
+
+#include <algorithm>
+#include <cmath>
+
+Bounds emptyBounds()
+{
+    Bounds bounds;
+    bounds.center = glm::vec3(0.0f);
+    bounds.radius = -1.0f;
+    bounds.min = glm::vec3(0.0f);
+    bounds.max = glm::vec3(0.0f);
+    return bounds;
+}
+
+Bounds computeBounds(const glm::vec3* points, size_t count)
+{
+    Bounds bounds = emptyBounds();
+    if (!count)
+    {
+        return bounds;
+    }
+
+    // The box, and the points at either end of it on each axis.
+    size_t lowest[3] = { 0, 0, 0 };
+    size_t highest[3] = { 0, 0, 0 };
+    bounds.min = points[0];
+    bounds.max = points[0];
+    for (size_t i = 1; i < count; i++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (points[i][axis] < points[lowest[axis]][axis])
+            {
+                lowest[axis] = i;
+            }
+            if (points[i][axis] > points[highest[axis]][axis])
+            {
+                highest[axis] = i;
+            }
+        }
+        bounds.min = glm::min(bounds.min, points[i]);
+        bounds.max = glm::max(bounds.max, points[i]);
+    }
+
+    int widest = 0;
+    float widestSpan = -1.0f;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        glm::vec3 span = points[highest[axis]] - points[lowest[axis]];
+        float spanSquared = glm::dot(span, span);
+        if (spanSquared > widestSpan)
+        {
+            widestSpan = spanSquared;
+            widest = axis;
+        }
+    }
+
+    // Start with the sphere through the widest pair and grow it just enough
+    // to take in each point left outside.
+    glm::vec3 center = (points[lowest[widest]] + points[highest[widest]]) * 0.5f;
+    float radius = std::sqrt(widestSpan) * 0.5f;
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 offset = points[i] - center;
+        float distance = glm::length(offset);
+        if (distance > radius)
+        {
+            float grown = (radius + distance) * 0.5f;
+            center += offset * ((grown - radius) / distance);
+            radius = grown;
+        }
+    }
+
+    bounds.center = center;
+    bounds.radius = radius;
+    return bounds;
+}
+
+Bounds transformBounds(const Bounds& bounds, const glm::mat4& transform)
+{
+    if (bounds.empty())
+    {
+        return bounds;
+    }
+
+    Bounds result;
+    result.center = glm::vec3(transform * glm::vec4(bounds.center, 1.0f));
+    float scale = std::max(glm::length(glm::vec3(transform[0])),
+                  std::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+    result.radius = bounds.radius * scale;
+
+    // Each output axis takes the smaller and larger end of every input axis
+    // (Arvo).
+    result.min = glm::vec3(transform[3]);
+    result.max = result.min;
+    for (int column = 0; column < 3; column++)
+    {
+        for (int row = 0; row < 3; row++)
+        {
+            float a = transform[column][row] * bounds.min[column];
+            float b = transform[column][row] * bounds.max[column];
+            result.min[row] += std::min(a, b);
+            result.max[row] += std::max(a, b);
+        }
+    }
+    return result;
+}
+
+void mergeBounds(Bounds& bounds, const Bounds& other)
+{
+    if (other.empty())
+    {
+        return;
+    }
+    if (bounds.empty())
+    {
+        bounds = other;
+        return;
+    }
+
+    // The smallest sphere around both spheres...
+    glm::vec3 offset = other.center - bounds.center;
+    float distance = glm::length(offset);
+    glm::vec3 center = bounds.center;
+    float radius = bounds.radius;
+    if (distance + bounds.radius <= other.radius)
+    {
+        center = other.center;
+        radius = other.radius;
+    }
+    else if (distance + other.radius > bounds.radius)
+    {
+        radius = (distance + bounds.radius + other.radius) * 0.5f;
+        center += offset * ((radius - bounds.radius) / distance);
+    }
+
+    // ...or one around the middle of the merged box, if that is smaller.
+    glm::vec3 low = glm::min(bounds.min, other.min);
+    glm::vec3 high = glm::max(bounds.max, other.max);
+    glm::vec3 middle = (low + high) * 0.5f;
+    float middleRadius = std::max(glm::length(bounds.center - middle) + bounds.radius,
+                                  glm::length(other.center - middle) + other.radius);
+    if (middleRadius < radius)
+    {
+        center = middle;
+        radius = middleRadius;
+    }
+
+    bounds.center = center;
+    bounds.radius = radius;
+    bounds.min = low;
+    bounds.max = high;
+}
@@ -0,0 +1,37 @@
+#ifndef _BOUNDS_H_
+#define _BOUNDS_H_
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// A bounding sphere and an axis aligned box around the same points. Either
+// may be the tighter one depending on the shape, so both are kept.
+struct Bounds
+{
+    glm::vec3 center;
+    // Negative when the bounds are empty.
+    float radius;
+    glm::vec3 min;
+    glm::vec3 max;
+
+    bool empty() const
+    {
+        return radius < 0.0f;
+    }
+};
+
+Bounds emptyBounds();
+
+// Ritter's bounding sphere, started from the pair of extreme points along
+// the axis they are farthest apart on, and the box around the points.
+Bounds computeBounds(const glm::vec3* points, size_t count);
+
+// Bounds of the points after transform, which may scale non-uniformly. The
+// sphere grows by the largest axis scale, the box is refitted around the
+// transformed box.
+Bounds transformBounds(const Bounds& bounds, const glm::mat4& transform);
+
+// Grows bounds to also enclose other.
+void mergeBounds(Bounds& bounds, const Bounds& other);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef _BUFFER_UPLOAD_H_
+#define _BUFFER_UPLOAD_H_
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#include <cstddef>
+
+// Copies an array into a GL buffer a piece at a time so a large mesh can be
+// spread over several frames. Uses GL_COPY_WRITE_BUFFER so it never disturbs
+// the array/element bindings of whatever VAO is current.
+struct BufferUpload
+{
+    GLuint buffer = 0;
+    const char* source = nullptr;
+    size_t size = 0;
+    size_t uploaded = 0;
+
+    void start(GLuint buffer, const void* source, size_t size)
+    {
+        this->buffer = buffer;
+        this->source = (const char*)source;
+        this->size = size;
+        uploaded = 0;
+
+        // Allocate the whole buffer up front; later steps only fill it in.
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STATIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    bool done() const
+    {
+        return uploaded >= size;
+    }
+
+    // Uploads at most budget bytes and subtracts what was used from it.
+    void step(size_t& budget)
+    {
+        size_t count = size - uploaded;
+        if (count > budget)
+        {
+            count = budget;
+        }
+        if (count == 0)
+        {
+            return;
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, uploaded, count, source + uploaded);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        uploaded += count;
+        budget -= count;
+    }
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "CubicBatch.h"
+
+#include <cmath>
+
+namespace
+{
+    // Parameters from first on, one at a time. The SIMD paths multiply and
+    // add in the same order, so all of them agree exactly.
+    void pointsScalar(const glm::vec3 coeff[4], const float* t, size_t first, size_t count, float* x, float* y,
+                      float* z)
+    {
+        for (size_t i = first; i < count; i++)
+        {
+            glm::vec3 point = ((coeff[0] * t[i] + coeff[1]) * t[i] + coeff[2]) * t[i] + coeff[3];
+            x[i] = point.x;
+            y[i] = point.y;
+            z[i] = point.z;
+        }
+    }
+
+    void speedsScalar(const glm::vec3 coeff[4], const float* t, size_t first, size_t count, float* speed)
+    {
+        glm::vec3 a = 3.0f * coeff[0];
+        glm::vec3 b = 2.0f * coeff[1];
+        for (size_t i = first; i < count; i++)
+        {
+            glm::vec3 tangent = (a * t[i] + b) * t[i] + coeff[2];
+            speed[i] = std::sqrt(tangent.x * tangent.x + tangent.y * tangent.y + tangent.z * tangent.z);
+        }
+    }
+
+#ifdef SIMD_X86
+    // Returns the first parameter left for the scalar tail.
+    size_t pointsSse(const glm::vec3 coeff[4], const float* t, size_t count, float* x, float* y, float* z)
+    {
+        float* out[3] = { x, y, z };
+        size_t end = count & ~(size_t)3;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            __m128 a = _mm_set1_ps(coeff[0][axis]);
+            __m128 b = _mm_set1_ps(coeff[1][axis]);
+            __m128 c = _mm_set1_ps(coeff[2][axis]);
+            __m128 d = _mm_set1_ps(coeff[3][axis]);
+            for (size_t i = 0; i < end; i += 4)
+            {
+                __m128 s = _mm_loadu_ps(t + i);
+                __m128 value = _mm_add_ps(_mm_mul_ps(a, s), b);
+                value = _mm_add_ps(_mm_mul_ps(value, s), c);
+                value = _mm_add_ps(_mm_mul_ps(value, s), d);
+                _mm_storeu_ps(out[axis] + i, value);
+            }
+        }
+        return end;
+    }
+
+    size_t speedsSse(const glm::vec3 coeff[4], const float* t, size_t count, float* speed)
+    {
+        __m128 a[3], b[3], c[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            a[axis] = _mm_set1_ps(3.0f * coeff[0][axis]);
+            b[axis] = _mm_set1_ps(2.0f * coeff[1][axis]);
+            c[axis] = _mm_set1_ps(coeff[2][axis]);
+        }
+        size_t end = count & ~(size_t)3;
+        for (size_t i = 0; i < end; i += 4)
+        {
+            __m128 s = _mm_loadu_ps(t + i);
+            __m128 sum = _mm_setzero_ps();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                __m128 tangent = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(a[axis], s), b[axis]), s), c[axis]);
+                sum = _mm_add_ps(sum, _mm_mul_ps(tangent, tangent));
+            }
+            _mm_storeu_ps(speed + i, _mm_sqrt_ps(sum));
+        }
+        return end;
+    }
+
+    TARGET_AVX2 size_t pointsAvx2(const glm::vec3 coeff[4], const float* t, size_t count, float* x, float* y,
+                                  float* z)
+    {
+        float* out[3] = { x, y, z };
+        size_t end = count & ~(size_t)7;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            __m256 a = _mm256_set1_ps(coeff[0][axis]);
+            __m256 b = _mm256_set1_ps(coeff[1][axis]);
+            __m256 c = _mm256_set1_ps(coeff[2][axis]);
+            __m256 d = _mm256_set1_ps(coeff[3][axis]);
+            for (size_t i = 0; i < end; i += 8)
+            {
+                __m256 s = _mm256_loadu_ps(t + i);
+                __m256 value = _mm256_add_ps(_mm256_mul_ps(a, s), b);
+                value = _mm256_add_ps(_mm256_mul_ps(value, s), c);
+                value = _mm256_add_ps(_mm256_mul_ps(value, s), d);
+                _mm256_storeu_ps(out[axis] + i, value);
+            }
+        }
+        return end;
+    }
+
+    TARGET_AVX2 size_t speedsAvx2(const glm::vec3 coeff[4], const float* t, size_t count, float* speed)
+    {
+        __m256 a[3], b[3], c[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            a[axis] = _mm256_set1_ps(3.0f * coeff[0][axis]);
+            b[axis] = _mm256_set1_ps(2.0f * coeff[1][axis]);
+            c[axis] = _mm256_set1_ps(coeff[2][axis]);
+        }
+        size_t end = count & ~(size_t)7;
+        for (size_t i = 0; i < end; i += 8)
+        {
+            __m256 s = _mm256_loadu_ps(t + i);
+            __m256 sum = _mm256_setzero_ps();
+            for (int axis = 0; axis < 3; axis++)
+            {
+                __m256 tangent = _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(a[axis], s), b[axis]), s),
+                                               c[axis]);
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(tangent, tangent));
+            }
+            _mm256_storeu_ps(speed + i, _mm256_sqrt_ps(sum));
+        }
+        return end;
+    }
+#endif
+}
+
+void evaluateCubicPoints(const glm::vec3 coeff[4], const float* t, size_t count, float* x, float* y, float* z,
+                         SimdPath path)
+{
+    size_t first = 0;
+#ifdef SIMD_X86
+    if (path == SIMD_PATH_AVX2 && bestSimdPath() == SIMD_PATH_AVX2)
+    {
+        first = pointsAvx2(coeff, t, count, x, y, z);
+    }
+    else if (path != SIMD_PATH_SCALAR)
+    {
+        first = pointsSse(coeff, t, count, x, y, z);
+    }
+#endif
+    pointsScalar(coeff, t, first, count, x, y, z);
+}
+
+void evaluateCubicSpeeds(const glm::vec3 coeff[4], const float* t, size_t count, float* speed, SimdPath path)
+{
+    size_t first = 0;
+#ifdef SIMD_X86
+    if (path == SIMD_PATH_AVX2 && bestSimdPath() == SIMD_PATH_AVX2)
+    {
+        first = speedsAvx2(coeff, t, count, speed);
+    }
+    else if (path != SIMD_PATH_SCALAR)
+    {
+        first = speedsSse(coeff, t, count, speed);
+    }
+#endif
+    speedsScalar(coeff, t, first, count, speed);
+}
@@ -0,0 +1,23 @@
+#ifndef _CUBIC_BATCH_H_
+#define _CUBIC_BATCH_H_
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+#include "SimdPath.h"
+
+// Cubic curves in power form, coeff[0] t^3 + coeff[1] t^2 + coeff[2] t +
+// coeff[3] (a Bezier curve once its control points are multiplied out),
+// evaluated at many parameters at once. Each point is three multiplies and
+// adds per axis with Horner's scheme, 4 or 8 parameters per instruction on
+// the same SIMD paths as the sphere culler. Results are one array per axis.
+
+// Points at t[0] to t[count - 1].
+void evaluateCubicPoints(const glm::vec3 coeff[4], const float* t, size_t count, float* x, float* y, float* z,
+                         SimdPath path = bestSimdPath());
+
+// Lengths of the derivative, how fast the curve moves per unit of t.
+void evaluateCubicSpeeds(const glm::vec3 coeff[4], const float* t, size_t count, float* speed,
+                         SimdPath path = bestSimdPath());
+
+#endif
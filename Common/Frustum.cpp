@@ -0,0 +1,45 @@
+#include "Frustum.h"
+
+namespace
+{
+    // Row i of a column major matrix.
+    inline glm::vec4 row(const glm::mat4& m, int i)
+    {
+        return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+}
+
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+    // A clip space point is inside when -w <= x, y, z <= w, so for example
+    // row3 + row0 >= 0 is the inside of the left plane. Negating turns the
+    // inward normals into outward ones.
+    glm::vec4 x = row(viewProjection, 0);
+    glm::vec4 y = row(viewProjection, 1);
+    glm::vec4 z = row(viewProjection, 2);
+    glm::vec4 w = row(viewProjection, 3);
+    planes[0] = -(w + z);
+    planes[1] = -(w - z);
+    planes[2] = -(w - x);
+    planes[3] = -(w + x);
+    planes[4] = -(w - y);
+    planes[5] = -(w + y);
+
+    // Unit normals, so the offsets are distances a radius can be compared to.
+    for (int i = 0; i < 6; i++)
+    {
+        planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+}
+
+bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, float radius)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w > radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,19 @@
+#ifndef _FRUSTUM_H_
+#define _FRUSTUM_H_
+
+#include <glm/glm.hpp>
+
+// The six planes of a view frustum as (outward unit normal, offset), so a
+// point p is outside a plane by dot(normal, p) + offset, in the order near,
+// far, right, left, top, bottom.
+//
+// Taken straight from projection * view (Gribb and Hartmann), so any camera
+// works, including ones whose view is set directly like a rider camera, and
+// near and far come from the projection. With projection * view * model the
+// planes come out in that model's space instead.
+void extractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+
+// False if the sphere is entirely outside one of the planes.
+bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, float radius);
+
+#endif
@@ -0,0 +1,137 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned threadCount, size_t queueCapacity)
+    : queued(0), stopping(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+    for (unsigned i = 0; i < threadCount; i++)
+    {
+        queues.emplace_back(new Queue());
+        queues.back()->jobs.resize(std::max(queueCapacity, (size_t)1));
+        queues.back()->head = 0;
+        queues.back()->count = 0;
+    }
+    for (unsigned i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(&JobSystem::work, this, (size_t)i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::runBatch(Batch& batch, size_t count, size_t grain)
+{
+    // Ranges are dealt out in turn, so no queue gets more than its share.
+    size_t capacity = queues[0]->jobs.size() * queues.size();
+    if ((count + grain - 1) / grain > capacity)
+    {
+        grain = (count + capacity - 1) / capacity;
+    }
+    size_t ranges = (count + grain - 1) / grain;
+    batch.remaining.store(ranges, std::memory_order_relaxed);
+    
+    // Every queue starts with a share and stealing only has to even out the
+    // difference.
+    for (size_t i = 0; i < ranges; i++)
+    {
+        Queue& queue = *queues[i % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        Job range = { &batch, i * grain, std::min(count, (i + 1) * grain) };
+        queue.jobs[(queue.head + queue.count) % queue.jobs.size()] = range;
+        queue.count++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        queued.fetch_add(ranges);
+    }
+    wake.notify_all();
+    
+    // Help until every range is done, including ones workers are still on.
+    while (batch.remaining.load(std::memory_order_acquire) > 0)
+    {
+        Job next;
+        if (take(0, next))
+        {
+            run(next);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::take(size_t thread, Job& job)
+{
+    // Newest first from the thread's own queue...
+    {
+        Queue& own = *queues[thread];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.count > 0)
+        {
+            own.count--;
+            job = own.jobs[(own.head + own.count) % own.jobs.size()];
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    
+    // ...then oldest first from the others, starting with the next one.
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        Queue& victim = *queues[(thread + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.count > 0)
+        {
+            job = victim.jobs[victim.head];
+            victim.head = (victim.head + 1) % victim.jobs.size();
+            victim.count--;
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::run(const Job& job)
+{
+    job.batch->call(job.batch->body, job.first, job.last);
+    // The batch may be gone as soon as this reaches 0.
+    job.batch->remaining.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::work(size_t thread)
+{
+    while (true)
+    {
+        Job job;
+        if (take(thread, job))
+        {
+            run(job);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wake.wait(lock, [this]() { return stopping || queued.load() > 0; });
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
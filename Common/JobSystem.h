@@ -0,0 +1,98 @@
+#ifndef _JOB_SYSTEM_H_
+#define _JOB_SYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Splits loops over independent items across threads. Every thread,
+// including the one calling parallelFor, has its own deque of jobs: it takes
+// from the back of its own and, once that is empty, steals from the front of
+// the others', so threads that get cheaper items help with the rest.
+//
+// The deques are rings of a fixed size set up front and the loop body is
+// called through a plain function pointer, so parallelFor doesn't allocate.
+class JobSystem
+{
+private:
+    struct Batch
+    {
+        // Calls the loop body, which is *body, on [first, last).
+        void (*call)(const void* body, size_t first, size_t last);
+        const void* body;
+        std::atomic<size_t> remaining;
+    };
+    struct Job
+    {
+        Batch* batch;
+        size_t first;
+        size_t last;
+    };
+    struct Queue
+    {
+        // jobs[head] is the front, and count jobs follow it round the ring.
+        std::vector<Job> jobs;
+        size_t head;
+        size_t count;
+        std::mutex mutex;
+    };
+
+    std::vector<std::thread> workers;
+    // Queue 0 belongs to the calling thread, queue i to workers[i - 1].
+    std::vector<std::unique_ptr<Queue>> queues;
+    // Jobs in all the queues, so idle workers can sleep until there are any.
+    std::atomic<size_t> queued;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping;
+
+    bool take(size_t thread, Job& job);
+    void run(const Job& job);
+    void work(size_t thread);
+    void runBatch(Batch& batch, size_t count, size_t grain);
+
+    template <typename Body>
+    static void call(const void* body, size_t first, size_t last)
+    {
+        (*(const Body*)body)(first, last);
+    }
+public:
+    // threadCount counts the calling thread, so 1 runs everything on it.
+    // Each thread's deque holds queueCapacity ranges; a loop with more than
+    // all of them together gets bigger ranges instead.
+    JobSystem(unsigned threadCount = std::thread::hardware_concurrency(), size_t queueCapacity = 256);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned threadCount() const { return (unsigned)queues.size(); }
+    // Calls body(first, last) for ranges of at least grain items that
+    // together cover [0, count), and returns once all of them have run. Only
+    // one thread may call this at a time, and not from inside a job.
+    template <typename Body>
+    void parallelFor(size_t count, size_t grain, const Body& body)
+    {
+        if (grain == 0)
+        {
+            grain = 1;
+        }
+        if (queues.size() == 1 || count <= grain)
+        {
+            if (count > 0)
+            {
+                body(0, count);
+            }
+            return;
+        }
+        Batch batch;
+        batch.call = &call<Body>;
+        batch.body = &body;
+        runBatch(batch, count, grain);
+    }
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename)
+    : bytes(nullptr), length(0), opened(false), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL)
+{
+    fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        return;
+    }
+    length = (size_t)fileSize.QuadPart;
+    opened = true;
+
+    // Empty files cannot be mapped, but they are still valid (empty) input.
+    if (length == 0)
+    {
+        return;
+    }
+
+    mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mappingHandle == NULL)
+    {
+        opened = false;
+        length = 0;
+        return;
+    }
+    bytes = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (bytes == nullptr)
+    {
+        opened = false;
+        length = 0;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (bytes != nullptr)
+    {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle != NULL)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(fileHandle);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename)
+    : bytes(nullptr), length(0), opened(false), fd(-1)
+{
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        return;
+    }
+    length = (size_t)info.st_size;
+    opened = true;
+
+    // Empty files cannot be mapped, but they are still valid (empty) input.
+    if (length == 0)
+    {
+        return;
+    }
+
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        opened = false;
+        length = 0;
+        return;
+    }
+    // We walk the file front to back exactly once.
+    madvise(mapped, length, MADV_SEQUENTIAL);
+    bytes = (const char*)mapped;
+}
+
+MappedFile::~MappedFile()
+{
+    if (bytes != nullptr)
+    {
+        munmap((void*)bytes, length);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The contents stay valid until the
+// MappedFile is destroyed, so parsers can work on the bytes in place instead
+// of copying them into strings first.
+class MappedFile
+{
+private:
+    const char* bytes;
+    size_t length;
+    bool opened;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+public:
+    MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return bytes; }
+    const char* end() const { return bytes + length; }
+    size_t size() const { return length; }
+};
+
+#endif
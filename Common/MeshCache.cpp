@@ -0,0 +1,324 @@
+#include "MeshCache.h"
+#include "MeshWelder.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+namespace
+{
+    const char cacheMagic[8] = { 'M', 'E', 'S', 'H', 'B', 'I', 'N', '\0' };
+    const uint32_t cacheVersion = 4;
+
+    // Size and modification time used to notice that the OBJ changed.
+    bool sourceStamp(const std::string& filename, uint64_t& size, int64_t& time)
+    {
+#ifdef _WIN32
+        struct _stat64 info;
+        if (_stat64(filename.c_str(), &info) != 0)
+        {
+            return false;
+        }
+#else
+        struct stat info;
+        if (stat(filename.c_str(), &info) != 0)
+        {
+            return false;
+        }
+#endif
+        size = (uint64_t)info.st_size;
+        time = (int64_t)info.st_mtime;
+        return true;
+    }
+
+    // Each layout gets its own cache so loading one OBJ two ways doesn't
+    // keep rewriting the same file.
+    std::string cacheName(const std::string& filename, MeshLayout layout, bool optimize)
+    {
+        const char* suffix = optimize ? ".opt.meshbin" : ".meshbin";
+        switch (layout)
+        {
+            case MESH_LAYOUT_POINTS:
+                return filename + ".points" + suffix;
+            case MESH_LAYOUT_SHARED_INDICES:
+                return filename + ".indexed" + suffix;
+            default:
+                return filename + ".welded" + suffix;
+        }
+    }
+
+    inline uint64_t alignTo16(uint64_t offset)
+    {
+        return (offset + 15) & ~(uint64_t)15;
+    }
+}
+
+MeshCache::MeshCache()
+    : mapping(nullptr), header(nullptr)
+{
+}
+
+MeshCache::~MeshCache()
+{
+    delete mapping;
+}
+
+bool MeshCache::openCache(const std::string& cacheFilename, const std::string& filename,
+                          MeshLayout layout, float radius, bool optimize, unsigned lodCount)
+{
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    bool haveSource = sourceStamp(filename, sourceSize, sourceTime);
+
+    MappedFile* file = new MappedFile(cacheFilename);
+    if (!file->isOpen() || file->size() < sizeof(MeshCacheHeader))
+    {
+        delete file;
+        return false;
+    }
+
+    const MeshCacheHeader* candidate = (const MeshCacheHeader*)file->data();
+    bool valid = std::memcmp(candidate->magic, cacheMagic, sizeof(cacheMagic)) == 0
+        && candidate->version == cacheVersion
+        && candidate->layout == (uint32_t)layout
+        && candidate->optimized == (optimize ? 1u : 0u)
+        && candidate->radius == radius
+        && candidate->requestedLods == lodCount
+        && candidate->lodCount <= maxMeshLods
+        && candidate->fileSize == file->size()
+        && candidate->positionsOffset + candidate->positionCount * sizeof(glm::vec3) <= file->size()
+        && candidate->normalsOffset + candidate->normalCount * sizeof(glm::vec3) <= file->size()
+        && candidate->indicesOffset + candidate->indexCount * sizeof(unsigned) <= file->size();
+
+    // A cache without its OBJ next to it is still usable; otherwise it has to
+    // match the OBJ it was built from.
+    if (valid && haveSource)
+    {
+        valid = candidate->sourceSize == sourceSize && candidate->sourceTime == sourceTime;
+    }
+
+    for (uint32_t i = 0; valid && i < candidate->lodCount; i++)
+    {
+        valid = (uint64_t)candidate->lods[i].indexOffset + candidate->lods[i].indexCount <= candidate->indexCount;
+    }
+
+    if (!valid)
+    {
+        delete file;
+        return false;
+    }
+
+    mapping = file;
+    header = candidate;
+    return true;
+}
+
+bool MeshCache::load(const std::string& filename, MeshLayout layout, float radius, bool optimize,
+                     unsigned lodCount)
+{
+    delete mapping;
+    mapping = nullptr;
+    header = nullptr;
+    data = MeshData();
+
+    // Points are drawn unindexed, so there is nothing to reorder.
+    optimize = optimize && layout != MESH_LAYOUT_POINTS;
+    lodCount = layout == MESH_LAYOUT_POINTS ? 1 : std::min(std::max(lodCount, 1u), maxMeshLods);
+
+    std::string cacheFilename = cacheName(filename, layout, optimize);
+    if (openCache(cacheFilename, filename, layout, radius, optimize, lodCount))
+    {
+        return true;
+    }
+
+    ObjMesh mesh;
+    if (!loadObj(filename, mesh))
+    {
+        return false;
+    }
+    normalizeObj(mesh, radius);
+    build(mesh, layout, data);
+
+    if (optimize)
+    {
+        VertexCacheStats before, after;
+        optimizeMesh(data, before, after);
+        printf("Optimized %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", filename.c_str(),
+               before.acmr, after.acmr, before.atvr, after.atvr);
+    }
+
+    if (lodCount > 1)
+    {
+        buildLods(data, lodCount);
+        printf("Simplified %s:", filename.c_str());
+        for (const MeshLod& level : data.lods)
+        {
+            printf(" %u", level.indexCount / 3);
+        }
+        printf(" triangles\n");
+    }
+
+    // Map what we just wrote so both paths hand the same memory to GL. If
+    // the cache can't be written we keep using the arrays in memory.
+    if (write(cacheFilename, filename, layout, radius, optimize, lodCount, data)
+        && openCache(cacheFilename, filename, layout, radius, optimize, lodCount))
+    {
+        data = MeshData();
+    }
+
+    return true;
+}
+
+const glm::vec3* MeshCache::positions() const
+{
+    if (header)
+    {
+        return (const glm::vec3*)(mapping->data() + header->positionsOffset);
+    }
+    return data.positions.data();
+}
+
+const glm::vec3* MeshCache::normals() const
+{
+    if (header)
+    {
+        return (const glm::vec3*)(mapping->data() + header->normalsOffset);
+    }
+    return data.normals.data();
+}
+
+const unsigned* MeshCache::indices() const
+{
+    if (header)
+    {
+        return (const unsigned*)(mapping->data() + header->indicesOffset);
+    }
+    return data.indices.data();
+}
+
+size_t MeshCache::positionCount() const
+{
+    return header ? header->positionCount : data.positions.size();
+}
+
+size_t MeshCache::normalCount() const
+{
+    return header ? header->normalCount : data.normals.size();
+}
+
+size_t MeshCache::indexCount() const
+{
+    return header ? header->indexCount : data.indices.size();
+}
+
+size_t MeshCache::lodCount() const
+{
+    size_t count = header ? header->lodCount : data.lods.size();
+    return count ? count : 1;
+}
+
+MeshLod MeshCache::lod(size_t level) const
+{
+    if (header && header->lodCount)
+    {
+        return header->lods[std::min(level, (size_t)header->lodCount - 1)];
+    }
+    if (!header && !data.lods.empty())
+    {
+        return data.lods[std::min(level, data.lods.size() - 1)];
+    }
+    MeshLod whole = { 0, (uint32_t)indexCount() };
+    return whole;
+}
+
+glm::vec3 MeshCache::min() const
+{
+    return header ? glm::vec3(header->min[0], header->min[1], header->min[2]) : data.min;
+}
+
+glm::vec3 MeshCache::max() const
+{
+    return header ? glm::vec3(header->max[0], header->max[1], header->max[2]) : data.max;
+}
+
+void MeshCache::build(const ObjMesh& mesh, MeshLayout layout, MeshData& result)
+{
+    result = MeshData();
+    result.min = mesh.min;
+    result.max = mesh.max;
+
+    switch (layout)
+    {
+        case MESH_LAYOUT_POINTS:
+            result.positions = mesh.points;
+            break;
+        case MESH_LAYOUT_SHARED_INDICES:
+            result.positions = mesh.points;
+            result.normals = mesh.normals;
+            result.indices.assign(mesh.vertexIndices.begin(), mesh.vertexIndices.end());
+            break;
+        case MESH_LAYOUT_WELDED:
+            weldMesh(mesh, result);
+            break;
+    }
+}
+
+bool MeshCache::write(const std::string& cacheFilename, const std::string& filename,
+                      MeshLayout layout, float radius, bool optimize, unsigned lodCount,
+                      const MeshData& mesh)
+{
+    MeshCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.layout = (uint32_t)layout;
+    header.optimized = optimize ? 1 : 0;
+    header.radius = radius;
+    header.positionCount = (uint32_t)mesh.positions.size();
+    header.normalCount = (uint32_t)mesh.normals.size();
+    header.indexCount = (uint32_t)mesh.indices.size();
+    sourceStamp(filename, header.sourceSize, header.sourceTime);
+    for (int i = 0; i < 3; i++)
+    {
+        header.min[i] = mesh.min[i];
+        header.max[i] = mesh.max[i];
+    }
+    header.requestedLods = lodCount;
+    header.lodCount = (uint32_t)std::min(mesh.lods.size(), (size_t)maxMeshLods);
+    for (uint32_t i = 0; i < header.lodCount; i++)
+    {
+        header.lods[i] = mesh.lods[i];
+    }
+    header.positionsOffset = alignTo16(sizeof(MeshCacheHeader));
+    header.normalsOffset = alignTo16(header.positionsOffset + mesh.positions.size() * sizeof(glm::vec3));
+    header.indicesOffset = alignTo16(header.normalsOffset + mesh.normals.size() * sizeof(glm::vec3));
+    header.fileSize = header.indicesOffset + mesh.indices.size() * sizeof(unsigned);
+
+    std::ofstream out(cacheFilename, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "Can't write the mesh cache " << cacheFilename << std::endl;
+        return false;
+    }
+
+    const char padding[16] = { 0 };
+    auto writeAt = [&](uint64_t offset, const void* bytes, size_t size) {
+        uint64_t position = (uint64_t)out.tellp();
+        out.write(padding, (std::streamsize)(offset - position));
+        out.write((const char*)bytes, (std::streamsize)size);
+    };
+
+    out.write((const char*)&header, sizeof(header));
+    writeAt(header.positionsOffset, mesh.positions.data(), mesh.positions.size() * sizeof(glm::vec3));
+    writeAt(header.normalsOffset, mesh.normals.data(), mesh.normals.size() * sizeof(glm::vec3));
+    writeAt(header.indicesOffset, mesh.indices.data(), mesh.indices.size() * sizeof(unsigned));
+
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,121 @@
+#ifndef _MESH_CACHE_H_
+#define _MESH_CACHE_H_
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "MappedFile.h"
+#include "ObjLoader.h"
+
+// How the OBJ is turned into GPU-ready arrays.
+enum MeshLayout
+{
+    // Only the points (PointCloud).
+    MESH_LAYOUT_POINTS = 1,
+    // Points and normals share the face vertex indices (Model, Sphere, ...).
+    MESH_LAYOUT_SHARED_INDICES = 2,
+    // One vertex per distinct (point, normal) pair used by the faces, so
+    // points and normals can use different indices in the file (Geometry).
+    MESH_LAYOUT_WELDED = 3
+};
+
+// Most levels of detail a mesh can carry, counting the full mesh.
+const unsigned maxMeshLods = 4;
+
+// A range of the index array drawing one level of detail.
+struct MeshLod
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+};
+
+// Normalized, GPU-ready mesh arrays.
+struct MeshData
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    // Every level of detail, one after the other.
+    std::vector<unsigned> indices;
+    // Empty unless levels of detail were built.
+    std::vector<MeshLod> lods;
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Header of a .meshbin file. All arrays follow it in the same file at the
+// given (16 byte aligned) offsets, so a mapped cache can be handed straight
+// to glBufferData.
+struct MeshCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t layout;
+    // Nonzero if the indices and vertices were reordered by optimizeMesh.
+    uint32_t optimized;
+    float radius;
+    uint32_t positionCount;
+    uint32_t normalCount;
+    uint32_t indexCount;
+    // Size and modification time of the OBJ the cache was built from.
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    float min[3];
+    float max[3];
+    // Levels of detail that were asked for and the ones actually built.
+    uint32_t requestedLods;
+    uint32_t lodCount;
+    MeshLod lods[maxMeshLods];
+    uint64_t positionsOffset;
+    uint64_t normalsOffset;
+    uint64_t indicesOffset;
+    uint64_t fileSize;
+};
+
+// A normalized mesh, either mapped from filename.<layout>[.opt].meshbin or, when
+// that is missing or doesn't match the OBJ any more, parsed from the OBJ and
+// written back to the cache for the next run.
+class MeshCache
+{
+private:
+    MappedFile* mapping;
+    const MeshCacheHeader* header;
+    MeshData data;
+
+    bool openCache(const std::string& cacheFilename, const std::string& filename,
+                   MeshLayout layout, float radius, bool optimize, unsigned lodCount);
+public:
+    MeshCache();
+    ~MeshCache();
+    MeshCache(const MeshCache&) = delete;
+    MeshCache& operator=(const MeshCache&) = delete;
+
+    // Returns false if neither the cache nor the OBJ could be read. With
+    // optimize, indexed layouts are reordered for the vertex cache before
+    // they are cached, so it only costs time when the cache is rebuilt. The
+    // same goes for simplifying them into lodCount levels of detail.
+    bool load(const std::string& filename, MeshLayout layout, float radius = 7.5f,
+              bool optimize = false, unsigned lodCount = 1);
+    bool isMapped() const { return header != nullptr; }
+
+    const glm::vec3* positions() const;
+    const glm::vec3* normals() const;
+    const unsigned* indices() const;
+    size_t positionCount() const;
+    size_t normalCount() const;
+    size_t indexCount() const;
+    // A mesh without levels of detail has one, covering all its indices.
+    size_t lodCount() const;
+    MeshLod lod(size_t level) const;
+    glm::vec3 min() const;
+    glm::vec3 max() const;
+
+    // Turns parsed (already normalized) OBJ arrays into layout.
+    static void build(const ObjMesh& mesh, MeshLayout layout, MeshData& result);
+    static bool write(const std::string& cacheFilename, const std::string& filename,
+                      MeshLayout layout, float radius, bool optimize, unsigned lodCount,
+                      const MeshData& mesh);
+};
+
+#endif
@@ -0,0 +1,335 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace
+{
+    // A cluster only becomes its own overdraw unit if restarting the cache
+    // there costs at most this much over the whole mesh's ACMR.
+    const float clusterThreshold = 1.05f;
+
+    // Triangles using each vertex, as offsets into one shared list.
+    struct Adjacency
+    {
+        std::vector<unsigned> offsets;
+        std::vector<unsigned> counts;
+        std::vector<unsigned> triangles;
+    };
+
+    void buildAdjacency(const std::vector<unsigned>& indices, size_t vertexCount, Adjacency& adjacency)
+    {
+        adjacency.counts.assign(vertexCount, 0);
+        for (unsigned index : indices)
+        {
+            adjacency.counts[index]++;
+        }
+
+        adjacency.offsets.assign(vertexCount, 0);
+        unsigned offset = 0;
+        for (size_t i = 0; i < vertexCount; i++)
+        {
+            adjacency.offsets[i] = offset;
+            offset += adjacency.counts[i];
+        }
+
+        adjacency.triangles.resize(indices.size());
+        std::vector<unsigned> filled(vertexCount, 0);
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            unsigned vertex = indices[i];
+            adjacency.triangles[adjacency.offsets[vertex] + filled[vertex]++] = (unsigned)(i / 3);
+        }
+    }
+
+    // Misses of triangles [begin, end) through an empty FIFO cache.
+    unsigned countMisses(const std::vector<unsigned>& indices, size_t begin, size_t end,
+                         std::vector<unsigned>& stamps, unsigned& time)
+    {
+        // Starting the clock past every old stamp empties the cache.
+        time += vertexCacheSize + 1;
+        unsigned misses = 0;
+        for (size_t i = begin * 3; i < end * 3; i++)
+        {
+            unsigned vertex = indices[i];
+            if (time - stamps[vertex] > vertexCacheSize)
+            {
+                stamps[vertex] = time++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+
+    // Tipsify (Sander et al. 2007). Writes the new triangle order to result
+    // and the triangle positions where the walk had to jump to an unrelated
+    // vertex to boundaries; those are where clusters may be split.
+    void tipsify(const std::vector<unsigned>& indices, size_t vertexCount,
+                 std::vector<unsigned>& result, std::vector<size_t>& boundaries)
+    {
+        Adjacency adjacency;
+        buildAdjacency(indices, vertexCount, adjacency);
+
+        std::vector<unsigned> live = adjacency.counts;
+        std::vector<unsigned> stamps(vertexCount, 0);
+        std::vector<bool> emitted(indices.size() / 3, false);
+        std::vector<unsigned> deadEnd;
+        std::vector<unsigned> candidates;
+
+        result.clear();
+        result.reserve(indices.size());
+        boundaries.clear();
+
+        unsigned time = vertexCacheSize + 1;
+        size_t cursor = 0;
+        long fanning = vertexCount ? 0 : -1;
+
+        while (fanning >= 0)
+        {
+            candidates.clear();
+
+            unsigned begin = adjacency.offsets[fanning];
+            unsigned end = begin + adjacency.counts[fanning];
+            for (unsigned i = begin; i < end; i++)
+            {
+                unsigned triangle = adjacency.triangles[i];
+                if (emitted[triangle])
+                {
+                    continue;
+                }
+                emitted[triangle] = true;
+
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    unsigned vertex = indices[triangle * 3 + corner];
+                    result.push_back(vertex);
+                    deadEnd.push_back(vertex);
+                    candidates.push_back(vertex);
+                    live[vertex]--;
+                    if (time - stamps[vertex] > vertexCacheSize)
+                    {
+                        stamps[vertex] = time++;
+                    }
+                }
+            }
+
+            // Prefer the candidate that will still be in the cache after its
+            // remaining triangles are emitted, oldest first.
+            fanning = -1;
+            int bestPriority = -1;
+            for (unsigned vertex : candidates)
+            {
+                if (live[vertex] == 0)
+                {
+                    continue;
+                }
+                int priority = 0;
+                if (time - stamps[vertex] + 2 * live[vertex] <= vertexCacheSize)
+                {
+                    priority = (int)(time - stamps[vertex]);
+                }
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    fanning = vertex;
+                }
+            }
+            if (fanning >= 0)
+            {
+                continue;
+            }
+
+            // Dead end: back up to a recently used vertex, or else scan for
+            // any vertex with triangles left.
+            while (!deadEnd.empty() && fanning < 0)
+            {
+                unsigned vertex = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[vertex] > 0)
+                {
+                    fanning = vertex;
+                }
+            }
+            if (fanning < 0)
+            {
+                while (cursor < vertexCount && live[cursor] == 0)
+                {
+                    cursor++;
+                }
+                if (cursor < vertexCount)
+                {
+                    fanning = (long)cursor;
+                }
+            }
+            boundaries.push_back(result.size() / 3);
+        }
+    }
+
+    // Splits the Tipsify order into clusters and sorts them by how much they
+    // face away from the mesh center, so front surfaces tend to land first.
+    void sortClusters(const MeshData& mesh, std::vector<unsigned>& indices,
+                      const std::vector<size_t>& boundaries)
+    {
+        size_t triangleCount = indices.size() / 3;
+        size_t vertexCount = mesh.positions.size();
+
+        VertexCacheStats whole = analyzeVertexCache(indices, vertexCount);
+        std::vector<unsigned> stamps(vertexCount, 0);
+        unsigned time = 0;
+
+        std::vector<size_t> starts;
+        starts.push_back(0);
+        size_t start = 0;
+        for (size_t boundary : boundaries)
+        {
+            if (boundary <= start || boundary >= triangleCount)
+            {
+                continue;
+            }
+            unsigned misses = countMisses(indices, start, boundary, stamps, time);
+            if (misses <= whole.acmr * clusterThreshold * (boundary - start))
+            {
+                starts.push_back(boundary);
+                start = boundary;
+            }
+        }
+        starts.push_back(triangleCount);
+
+        if (starts.size() <= 2)
+        {
+            return;
+        }
+
+        glm::vec3 center(0.0f);
+        float totalArea = 0.0f;
+        std::vector<std::pair<float, size_t>> keys;
+        std::vector<glm::vec3> centroids;
+        std::vector<glm::vec3> normals;
+        for (size_t c = 0; c + 1 < starts.size(); c++)
+        {
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = starts[c]; t < starts[c + 1]; t++)
+            {
+                const glm::vec3& a = mesh.positions[indices[t * 3]];
+                const glm::vec3& b = mesh.positions[indices[t * 3 + 1]];
+                const glm::vec3& d = mesh.positions[indices[t * 3 + 2]];
+                glm::vec3 weighted = glm::cross(b - a, d - a);
+                float triangleArea = glm::length(weighted);
+                centroid += (a + b + d) * (triangleArea / 3.0f);
+                normal += weighted;
+                area += triangleArea;
+            }
+            center += centroid;
+            totalArea += area;
+            centroids.push_back(area > 0.0f ? centroid / area : mesh.positions[indices[starts[c] * 3]]);
+            normals.push_back(normal);
+        }
+        if (totalArea > 0.0f)
+        {
+            center /= totalArea;
+        }
+
+        for (size_t c = 0; c < centroids.size(); c++)
+        {
+            float length = glm::length(normals[c]);
+            float key = length > 0.0f ? glm::dot(centroids[c] - center, normals[c] / length) : 0.0f;
+            keys.push_back(std::make_pair(-key, c));
+        }
+        std::stable_sort(keys.begin(), keys.end());
+
+        std::vector<unsigned> sorted;
+        sorted.reserve(indices.size());
+        for (const std::pair<float, size_t>& key : keys)
+        {
+            sorted.insert(sorted.end(), indices.begin() + starts[key.second] * 3,
+                          indices.begin() + starts[key.second + 1] * 3);
+        }
+        indices.swap(sorted);
+    }
+
+    // Renumbers vertices in first use order.
+    void reorderVertices(MeshData& mesh)
+    {
+        // Normals share the position indices in every layout, so they go
+        // through the same table whenever there are any. One a face uses but
+        // the file didn't have comes out zero instead of being read past the
+        // end, so afterwards there is exactly one normal per position.
+        bool remapNormals = !mesh.normals.empty();
+
+        const unsigned unused = ~0u;
+        std::vector<unsigned> remap(mesh.positions.size(), unused);
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        positions.reserve(mesh.positions.size());
+        if (remapNormals)
+        {
+            normals.reserve(mesh.positions.size());
+        }
+
+        for (unsigned& index : mesh.indices)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = (unsigned)positions.size();
+                positions.push_back(mesh.positions[index]);
+                if (remapNormals)
+                {
+                    normals.push_back(index < mesh.normals.size() ? mesh.normals[index] : glm::vec3(0.0f));
+                }
+            }
+            index = remap[index];
+        }
+
+        mesh.positions.swap(positions);
+        if (remapNormals)
+        {
+            mesh.normals.swap(normals);
+        }
+    }
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned>& indices, size_t vertexCount)
+{
+    VertexCacheStats stats = { 0.0f, 0.0f };
+    if (indices.empty() || vertexCount == 0)
+    {
+        return stats;
+    }
+
+    std::vector<unsigned> stamps(vertexCount, 0);
+    unsigned time = 0;
+    unsigned misses = countMisses(indices, 0, indices.size() / 3, stamps, time);
+
+    // Only count vertices the triangles actually use.
+    size_t used = 0;
+    std::vector<bool> seen(vertexCount, false);
+    for (unsigned index : indices)
+    {
+        if (!seen[index])
+        {
+            seen[index] = true;
+            used++;
+        }
+    }
+
+    stats.acmr = (float)misses / (indices.size() / 3);
+    stats.atvr = (float)misses / used;
+    return stats;
+}
+
+void optimizeMesh(MeshData& mesh, VertexCacheStats& before, VertexCacheStats& after)
+{
+    before = analyzeVertexCache(mesh.indices, mesh.positions.size());
+
+    std::vector<unsigned> ordered;
+    std::vector<size_t> boundaries;
+    tipsify(mesh.indices, mesh.positions.size(), ordered, boundaries);
+    sortClusters(mesh, ordered, boundaries);
+    mesh.indices.swap(ordered);
+
+    reorderVertices(mesh);
+
+    after = analyzeVertexCache(mesh.indices, mesh.positions.size());
+}
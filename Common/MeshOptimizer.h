@@ -0,0 +1,29 @@
+#ifndef _MESH_OPTIMIZER_H_
+#define _MESH_OPTIMIZER_H_
+
+#include <vector>
+
+#include "MeshCache.h"
+
+// Size of the post-transform vertex cache the orderings are tuned for.
+const unsigned vertexCacheSize = 16;
+
+// Average cache miss ratio (misses per triangle) and average transform to
+// vertex ratio (misses per vertex) of a triangle list run through a FIFO
+// cache of vertexCacheSize entries.
+struct VertexCacheStats
+{
+    float acmr;
+    float atvr;
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned>& indices, size_t vertexCount);
+
+// Reorders the triangles of mesh for the vertex cache (Tipsify), then sorts
+// the resulting clusters so outward facing ones are drawn first to cut
+// overdraw, and finally renumbers the vertices in the order they are first
+// used so fetches walk the vertex buffer front to back. Vertices no triangle
+// uses are dropped. Stats before and after go to before and after.
+void optimizeMesh(MeshData& mesh, VertexCacheStats& before, VertexCacheStats& after);
+
+#endif
@@ -0,0 +1,398 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace
+{
+    // Borders get planes perpendicular to their faces, weighted up so open
+    // edges don't shrink away.
+    const double borderWeight = 10.0;
+
+    // Symmetric 4x4 matrix summing squared distances to a set of planes.
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+
+        void addPlane(const glm::vec3& normal, float distance, double weight)
+        {
+            double a = normal.x, b = normal.y, c = normal.z, d = distance;
+            a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+            b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+            c2 += weight * c * c; cd += weight * c * d;
+            d2 += weight * d * d;
+        }
+
+        void add(const Quadric& other)
+        {
+            a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+            b2 += other.b2; bc += other.bc; bd += other.bd;
+            c2 += other.c2; cd += other.cd;
+            d2 += other.d2;
+        }
+
+        double error(const glm::vec3& p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                 + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                 + c2 * z * z + 2 * cd * z
+                 + d2;
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        unsigned from;
+        unsigned to;
+
+        bool operator<(const Collapse& other) const
+        {
+            return cost < other.cost;
+        }
+    };
+
+    inline uint64_t edgeKey(unsigned a, unsigned b)
+    {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    inline bool lessPosition(const glm::vec3& a, const glm::vec3& b)
+    {
+        if (a.x != b.x)
+        {
+            return a.x < b.x;
+        }
+        if (a.y != b.y)
+        {
+            return a.y < b.y;
+        }
+        return a.z < b.z;
+    }
+
+    unsigned findGroup(std::vector<unsigned>& remap, unsigned group)
+    {
+        unsigned root = group;
+        while (remap[root] != root)
+        {
+            root = remap[root];
+        }
+        while (remap[group] != root)
+        {
+            unsigned next = remap[group];
+            remap[group] = root;
+            group = next;
+        }
+        return root;
+    }
+}
+
+float simplifyMesh(const MeshData& mesh, const unsigned* indices, size_t indexCount,
+                   size_t targetIndexCount, std::vector<unsigned>& result)
+{
+    size_t vertexCount = mesh.positions.size();
+
+    // Vertices welded at the same position but with different normals are
+    // one position group, so seams collapse together instead of tearing.
+    std::vector<unsigned> order(vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        order[i] = (unsigned)i;
+    }
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) {
+        return lessPosition(mesh.positions[a], mesh.positions[b]);
+    });
+
+    std::vector<unsigned> groupOf(vertexCount);
+    std::vector<glm::vec3> groupPositions;
+    std::vector<unsigned> wedgeOffsets;
+    for (size_t i = 0; i < vertexCount; i++)
+    {
+        if (i == 0 || mesh.positions[order[i]] != mesh.positions[order[i - 1]])
+        {
+            groupPositions.push_back(mesh.positions[order[i]]);
+            wedgeOffsets.push_back((unsigned)i);
+        }
+        groupOf[order[i]] = (unsigned)groupPositions.size() - 1;
+    }
+    wedgeOffsets.push_back((unsigned)vertexCount);
+    size_t groupCount = groupPositions.size();
+
+    // Triangles as position groups, plus the vertex each corner started as.
+    std::vector<unsigned> triangles;
+    std::vector<unsigned> corners;
+    triangles.reserve(indexCount);
+    corners.reserve(indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        unsigned a = groupOf[indices[i]], b = groupOf[indices[i + 1]], c = groupOf[indices[i + 2]];
+        if (a == b || b == c || c == a)
+        {
+            continue;
+        }
+        triangles.insert(triangles.end(), { a, b, c });
+        corners.insert(corners.end(), { indices[i], indices[i + 1], indices[i + 2] });
+    }
+
+    std::vector<Quadric> quadrics(groupCount);
+    std::vector<uint64_t> edges;
+    for (size_t t = 0; t < triangles.size(); t += 3)
+    {
+        const glm::vec3& p0 = groupPositions[triangles[t]];
+        glm::vec3 normal = glm::cross(groupPositions[triangles[t + 1]] - p0, groupPositions[triangles[t + 2]] - p0);
+        float length = glm::length(normal);
+        if (length == 0.0f)
+        {
+            continue;
+        }
+        normal /= length;
+        for (int k = 0; k < 3; k++)
+        {
+            quadrics[triangles[t + k]].addPlane(normal, -glm::dot(normal, p0), length * 0.5);
+            edges.push_back(edgeKey(triangles[t + k], triangles[t + (k + 1) % 3]));
+        }
+    }
+
+    // Edges used by only one triangle are borders.
+    std::sort(edges.begin(), edges.end());
+    for (size_t t = 0; t < triangles.size(); t += 3)
+    {
+        const glm::vec3& p0 = groupPositions[triangles[t]];
+        glm::vec3 faceNormal = glm::cross(groupPositions[triangles[t + 1]] - p0, groupPositions[triangles[t + 2]] - p0);
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned a = triangles[t + k], b = triangles[t + (k + 1) % 3];
+            uint64_t key = edgeKey(a, b);
+            auto range = std::equal_range(edges.begin(), edges.end(), key);
+            if (range.second - range.first != 1)
+            {
+                continue;
+            }
+            glm::vec3 edge = groupPositions[b] - groupPositions[a];
+            glm::vec3 normal = glm::cross(edge, faceNormal);
+            float length = glm::length(normal);
+            if (length == 0.0f)
+            {
+                continue;
+            }
+            normal /= length;
+            double weight = borderWeight * glm::dot(edge, edge);
+            quadrics[a].addPlane(normal, -glm::dot(normal, groupPositions[a]), weight);
+            quadrics[b].addPlane(normal, -glm::dot(normal, groupPositions[a]), weight);
+        }
+    }
+
+    std::vector<unsigned> remap(groupCount);
+    for (size_t g = 0; g < groupCount; g++)
+    {
+        remap[g] = (unsigned)g;
+    }
+
+    std::vector<Collapse> collapses;
+    std::vector<unsigned> adjacencyOffsets;
+    std::vector<unsigned> adjacency;
+    std::vector<bool> locked;
+    double maxError = 0.0;
+
+    // Each pass collapses a set of edges whose vertices don't touch, cheapest
+    // first, then rebuilds the triangle list.
+    while (triangles.size() > targetIndexCount)
+    {
+        edges.clear();
+        for (size_t t = 0; t < triangles.size(); t += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                edges.push_back(edgeKey(triangles[t + k], triangles[t + (k + 1) % 3]));
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+        collapses.clear();
+        for (uint64_t key : edges)
+        {
+            unsigned a = (unsigned)(key >> 32), b = (unsigned)key;
+            Quadric sum = quadrics[a];
+            sum.add(quadrics[b]);
+            double intoB = sum.error(groupPositions[b]);
+            double intoA = sum.error(groupPositions[a]);
+            if (intoB <= intoA)
+            {
+                collapses.push_back({ intoB, a, b });
+            }
+            else
+            {
+                collapses.push_back({ intoA, b, a });
+            }
+        }
+        std::sort(collapses.begin(), collapses.end());
+
+        adjacencyOffsets.assign(groupCount + 1, 0);
+        for (unsigned group : triangles)
+        {
+            adjacencyOffsets[group + 1]++;
+        }
+        for (size_t g = 0; g < groupCount; g++)
+        {
+            adjacencyOffsets[g + 1] += adjacencyOffsets[g];
+        }
+        adjacency.resize(triangles.size());
+        std::vector<unsigned> filled(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < triangles.size(); i++)
+        {
+            adjacency[filled[triangles[i]]++] = (unsigned)(i / 3);
+        }
+
+        locked.assign(groupCount, false);
+        size_t removable = (triangles.size() - targetIndexCount) / 3;
+        size_t removed = 0;
+        bool collapsed = false;
+
+        for (const Collapse& collapse : collapses)
+        {
+            if (removed >= removable)
+            {
+                break;
+            }
+            if (locked[collapse.from] || locked[collapse.to])
+            {
+                continue;
+            }
+
+            // Reject the collapse if it would flip any triangle that stays.
+            bool flips = false;
+            size_t shared = 0;
+            const glm::vec3& target = groupPositions[collapse.to];
+            for (unsigned i = adjacencyOffsets[collapse.from]; i < adjacencyOffsets[collapse.from + 1] && !flips; i++)
+            {
+                unsigned t = adjacency[i] * 3;
+                unsigned g[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    g[k] = findGroup(remap, triangles[t + k]);
+                }
+                if (g[0] == collapse.to || g[1] == collapse.to || g[2] == collapse.to)
+                {
+                    shared++;
+                    continue;
+                }
+
+                glm::vec3 before[3], after[3];
+                for (int k = 0; k < 3; k++)
+                {
+                    before[k] = groupPositions[g[k]];
+                    after[k] = g[k] == collapse.from ? target : before[k];
+                }
+                glm::vec3 oldNormal = glm::cross(before[1] - before[0], before[2] - before[0]);
+                glm::vec3 newNormal = glm::cross(after[1] - after[0], after[2] - after[0]);
+                flips = glm::dot(oldNormal, newNormal) <= 0.0f;
+            }
+            if (flips)
+            {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            locked[collapse.from] = true;
+            locked[collapse.to] = true;
+            removed += shared;
+            collapsed = true;
+            maxError = std::max(maxError, collapse.cost);
+        }
+
+        if (!collapsed)
+        {
+            break;
+        }
+
+        size_t kept = 0;
+        for (size_t t = 0; t < triangles.size(); t += 3)
+        {
+            unsigned a = findGroup(remap, triangles[t]);
+            unsigned b = findGroup(remap, triangles[t + 1]);
+            unsigned c = findGroup(remap, triangles[t + 2]);
+            if (a == b || b == c || c == a)
+            {
+                continue;
+            }
+            triangles[kept] = a;
+            triangles[kept + 1] = b;
+            triangles[kept + 2] = c;
+            corners[kept] = corners[t];
+            corners[kept + 1] = corners[t + 1];
+            corners[kept + 2] = corners[t + 2];
+            kept += 3;
+        }
+        triangles.resize(kept);
+        corners.resize(kept);
+    }
+
+    // Give each corner the vertex of its new position whose normal is
+    // closest to the one it had.
+    bool haveNormals = mesh.normals.size() == vertexCount;
+    result.resize(triangles.size());
+    for (size_t i = 0; i < triangles.size(); i++)
+    {
+        unsigned vertex = corners[i];
+        unsigned group = triangles[i];
+        if (groupOf[vertex] == group)
+        {
+            result[i] = vertex;
+            continue;
+        }
+
+        unsigned best = order[wedgeOffsets[group]];
+        if (haveNormals)
+        {
+            float bestDot = -2.0f;
+            for (unsigned w = wedgeOffsets[group]; w < wedgeOffsets[group + 1]; w++)
+            {
+                float d = glm::dot(mesh.normals[order[w]], mesh.normals[vertex]);
+                if (d > bestDot)
+                {
+                    bestDot = d;
+                    best = order[w];
+                }
+            }
+        }
+        result[i] = best;
+    }
+
+    return (float)maxError;
+}
+
+void buildLods(MeshData& mesh, unsigned lodCount)
+{
+    lodCount = std::min(std::max(lodCount, 1u), maxMeshLods);
+
+    mesh.lods.clear();
+    mesh.lods.push_back({ 0, (uint32_t)mesh.indices.size() });
+
+    std::vector<unsigned> simplified;
+    for (unsigned level = 1; level < lodCount; level++)
+    {
+        MeshLod previous = mesh.lods.back();
+        size_t target = previous.indexCount / 6 * 3;
+        if (target < 3)
+        {
+            break;
+        }
+
+        simplifyMesh(mesh, mesh.indices.data() + previous.indexOffset, previous.indexCount, target, simplified);
+        // Stop once the mesh won't get any simpler.
+        if (simplified.empty() || simplified.size() >= previous.indexCount)
+        {
+            break;
+        }
+
+        mesh.lods.push_back({ (uint32_t)mesh.indices.size(), (uint32_t)simplified.size() });
+        mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+    }
+}
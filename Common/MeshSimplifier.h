@@ -0,0 +1,21 @@
+#ifndef _MESH_SIMPLIFIER_H_
+#define _MESH_SIMPLIFIER_H_
+
+#include <vector>
+
+#include "MeshCache.h"
+
+// Quadric error metric edge collapse (Garland and Heckbert 1997). Collapses
+// vertices onto their neighbours until at most targetIndexCount indices are
+// left, writing the remaining triangles to result. The vertices themselves
+// are left alone, so every simplified index list can share the mesh's vertex
+// buffer. Returns the largest quadric error of a collapse that was made.
+float simplifyMesh(const MeshData& mesh, const unsigned* indices, size_t indexCount,
+                   size_t targetIndexCount, std::vector<unsigned>& result);
+
+// Appends up to lodCount - 1 simplified copies of the mesh's triangles to
+// its indices, each with about half the triangles of the one before, and
+// records every level (the full mesh first) in mesh.lods.
+void buildLods(MeshData& mesh, unsigned lodCount);
+
+#endif
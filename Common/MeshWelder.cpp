@@ -0,0 +1,94 @@
+#include "MeshWelder.h"
+
+#include <cstring>
+#include <cstdint>
+
+namespace
+{
+    struct WeldKey
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+    };
+
+    inline uint32_t floatBits(float value)
+    {
+        // +0 and -0 compare equal, so they must hash the same.
+        if (value == 0.0f)
+        {
+            value = 0.0f;
+        }
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline uint32_t hashKey(const WeldKey& key)
+    {
+        const float values[6] = {
+            key.position.x, key.position.y, key.position.z,
+            key.normal.x, key.normal.y, key.normal.z
+        };
+        uint32_t hash = 2166136261u;
+        for (float value : values)
+        {
+            hash ^= floatBits(value);
+            hash *= 16777619u;
+            hash ^= hash >> 15;
+        }
+        return hash;
+    }
+
+    inline bool sameKey(const WeldKey& a, const glm::vec3& position, const glm::vec3& normal)
+    {
+        return a.position == position && a.normal == normal;
+    }
+}
+
+void weldMesh(const ObjMesh& mesh, MeshData& result)
+{
+    result = MeshData();
+    result.min = mesh.min;
+    result.max = mesh.max;
+
+    size_t cornerCount = mesh.vertexIndices.size();
+    result.indices.reserve(cornerCount);
+
+    // Open addressing table of vertex ids, at most half full.
+    size_t tableSize = 16;
+    while (tableSize < cornerCount * 2)
+    {
+        tableSize *= 2;
+    }
+    const unsigned empty = ~0u;
+    std::vector<unsigned> table(tableSize, empty);
+    size_t mask = tableSize - 1;
+
+    const glm::vec3 noNormal(0.0f);
+    for (size_t i = 0; i < cornerCount; i++)
+    {
+        const glm::vec3& position = mesh.points[mesh.vertexIndices[i]];
+        int normalIndex = mesh.normalIndices[i];
+        const glm::vec3& normal = normalIndex >= 0 ? mesh.normals[normalIndex] : noNormal;
+
+        WeldKey key = { position, normal };
+        size_t slot = hashKey(key) & mask;
+        while (table[slot] != empty)
+        {
+            unsigned vertex = table[slot];
+            if (sameKey({ result.positions[vertex], result.normals[vertex] }, position, normal))
+            {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+
+        if (table[slot] == empty)
+        {
+            table[slot] = (unsigned)result.positions.size();
+            result.positions.push_back(position);
+            result.normals.push_back(normal);
+        }
+        result.indices.push_back(table[slot]);
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef _MESH_WELDER_H_
+#define _MESH_WELDER_H_
+
+#include "MeshCache.h"
+#include "ObjLoader.h"
+
+// Builds an indexed mesh from the face corners of an OBJ, giving every
+// distinct (position, normal) pair one vertex. OBJ files index points and
+// normals separately, so without this each corner would need its own vertex.
+void weldMesh(const ObjMesh& mesh, MeshData& result);
+
+#endif
@@ -0,0 +1,557 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+
+#include <iostream>
+#include <cstdint>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace
+{
+    const double powersOfTen[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    inline bool isDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    inline void skipSpaces(const char*& cur, const char* end)
+    {
+        while (cur < end && (*cur == ' ' || *cur == '\t'))
+        {
+            cur++;
+        }
+    }
+
+    inline void skipLine(const char*& cur, const char* end)
+    {
+        while (cur < end && *cur != '\n')
+        {
+            cur++;
+        }
+        if (cur < end)
+        {
+            cur++;
+        }
+    }
+
+    inline bool atLineEnd(const char* cur, const char* end)
+    {
+        return cur >= end || *cur == '\n' || *cur == '\r' || *cur == '#';
+    }
+
+    // Parses [+-]digits[.digits][(e|E)[+-]digits]. Leaves cur untouched and
+    // returns false if there is no number here.
+    bool parseFloat(const char*& cur, const char* end, float& value)
+    {
+        const char* p = cur;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            p++;
+        }
+
+        uint64_t mantissa = 0;
+        int exponent = 0;
+        int digits = 0;
+        bool anyDigits = false;
+
+        while (p < end && isDigit(*p))
+        {
+            // Past 19 significant digits we only track magnitude.
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0)
+                {
+                    digits++;
+                }
+            }
+            else
+            {
+                exponent++;
+            }
+            anyDigits = true;
+            p++;
+        }
+        if (p < end && *p == '.')
+        {
+            p++;
+            while (p < end && isDigit(*p))
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    if (mantissa != 0)
+                    {
+                        digits++;
+                    }
+                    exponent--;
+                }
+                anyDigits = true;
+                p++;
+            }
+        }
+        if (!anyDigits)
+        {
+            return false;
+        }
+
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char* e = p + 1;
+            bool negativeExp = false;
+            if (e < end && (*e == '-' || *e == '+'))
+            {
+                negativeExp = *e == '-';
+                e++;
+            }
+            if (e < end && isDigit(*e))
+            {
+                int exp = 0;
+                while (e < end && isDigit(*e))
+                {
+                    if (exp < 10000)
+                    {
+                        exp = exp * 10 + (*e - '0');
+                    }
+                    e++;
+                }
+                exponent += negativeExp ? -exp : exp;
+                p = e;
+            }
+        }
+
+        double result = (double)mantissa;
+        while (exponent > 22)
+        {
+            result *= 1e22;
+            exponent -= 22;
+        }
+        while (exponent < -22)
+        {
+            result /= 1e22;
+            exponent += 22;
+        }
+        if (exponent >= 0)
+        {
+            result *= powersOfTen[exponent];
+        }
+        else
+        {
+            result /= powersOfTen[-exponent];
+        }
+
+        value = (float)(negative ? -result : result);
+        cur = p;
+        return true;
+    }
+
+    bool parseInt(const char*& cur, const char* end, int& value)
+    {
+        const char* p = cur;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            p++;
+        }
+        if (p >= end || !isDigit(*p))
+        {
+            return false;
+        }
+        int result = 0;
+        while (p < end && isDigit(*p))
+        {
+            result = result * 10 + (*p - '0');
+            p++;
+        }
+        value = negative ? -result : result;
+        cur = p;
+        return true;
+    }
+
+    // A slice of the file parsed independently of the others. Negative
+    // (relative) indices can only be resolved against counts local to the
+    // chunk, so their positions are remembered and offset while stitching.
+    struct ObjChunk
+    {
+        ObjMesh mesh;
+        std::vector<size_t> relativeVertices;
+        std::vector<size_t> relativeTexCoords;
+        std::vector<size_t> relativeNormals;
+    };
+
+    // OBJ indices are one based, and negative ones count back from the most
+    // recently defined element.
+    inline int resolveIndex(int index, size_t count, bool& relative)
+    {
+        relative = index < 0;
+        if (index > 0)
+        {
+            return index - 1;
+        }
+        if (index < 0)
+        {
+            return (int)count + index;
+        }
+        return -1;
+    }
+
+    struct Corner
+    {
+        int v, vt, vn;
+        bool relativeV, relativeVt, relativeVn;
+    };
+
+    // Reads one "v", "v/vt", "v//vn" or "v/vt/vn" group.
+    bool parseCorner(const char*& cur, const char* end, const ObjMesh& mesh, Corner& corner)
+    {
+        int index;
+        if (!parseInt(cur, end, index))
+        {
+            return false;
+        }
+        corner.v = resolveIndex(index, mesh.points.size(), corner.relativeV);
+        corner.vt = -1;
+        corner.vn = -1;
+        corner.relativeVt = false;
+        corner.relativeVn = false;
+
+        if (cur < end && *cur == '/')
+        {
+            cur++;
+            if (parseInt(cur, end, index))
+            {
+                corner.vt = resolveIndex(index, mesh.texCoords.size(), corner.relativeVt);
+            }
+            if (cur < end && *cur == '/')
+            {
+                cur++;
+                if (parseInt(cur, end, index))
+                {
+                    corner.vn = resolveIndex(index, mesh.normals.size(), corner.relativeVn);
+                }
+            }
+        }
+        // Skip anything unexpected up to the next separator.
+        while (cur < end && *cur != ' ' && *cur != '\t' && !atLineEnd(cur, end))
+        {
+            cur++;
+        }
+        return true;
+    }
+
+    inline void pushCorner(ObjChunk& chunk, const Corner& corner)
+    {
+        ObjMesh& mesh = chunk.mesh;
+        size_t position = mesh.vertexIndices.size();
+        if (corner.relativeV)
+        {
+            chunk.relativeVertices.push_back(position);
+        }
+        if (corner.relativeVt)
+        {
+            chunk.relativeTexCoords.push_back(position);
+        }
+        if (corner.relativeVn)
+        {
+            chunk.relativeNormals.push_back(position);
+        }
+        mesh.vertexIndices.push_back(corner.v);
+        mesh.texCoordIndices.push_back(corner.vt);
+        mesh.normalIndices.push_back(corner.vn);
+    }
+
+    void parseFace(const char*& cur, const char* end, ObjChunk& chunk)
+    {
+        Corner first, previous, corner;
+        int count = 0;
+
+        skipSpaces(cur, end);
+        while (!atLineEnd(cur, end) && parseCorner(cur, end, chunk.mesh, corner))
+        {
+            // Triangulate polygons as a fan around the first corner.
+            if (count >= 2)
+            {
+                pushCorner(chunk, first);
+                pushCorner(chunk, previous);
+                pushCorner(chunk, corner);
+            }
+            else if (count == 0)
+            {
+                first = corner;
+            }
+            previous = corner;
+            count++;
+            skipSpaces(cur, end);
+        }
+    }
+
+    bool parseVec3(const char*& cur, const char* end, glm::vec3& v)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            skipSpaces(cur, end);
+            if (!parseFloat(cur, end, v[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Parses whole lines in [cur, end), computing the bounds of the points
+    // as they are read.
+    void parseChunk(const char* cur, const char* end, ObjChunk& chunk)
+    {
+        ObjMesh& mesh = chunk.mesh;
+        glm::vec3 minPoint(FLT_MAX), maxPoint(-FLT_MAX);
+
+        while (cur < end)
+        {
+            skipSpaces(cur, end);
+            if (cur >= end)
+            {
+                break;
+            }
+
+            if (cur[0] == 'v')
+            {
+                char kind = cur + 1 < end ? cur[1] : '\n';
+                if (kind == ' ' || kind == '\t')
+                {
+                    cur += 2;
+                    glm::vec3 point;
+                    if (parseVec3(cur, end, point))
+                    {
+                        mesh.points.push_back(point);
+                        minPoint = glm::min(minPoint, point);
+                        maxPoint = glm::max(maxPoint, point);
+                    }
+                }
+                else if (kind == 'n' && cur + 2 < end && (cur[2] == ' ' || cur[2] == '\t'))
+                {
+                    cur += 3;
+                    glm::vec3 normal;
+                    if (parseVec3(cur, end, normal))
+                    {
+                        mesh.normals.push_back(normal);
+                    }
+                }
+                else if (kind == 't' && cur + 2 < end && (cur[2] == ' ' || cur[2] == '\t'))
+                {
+                    cur += 3;
+                    glm::vec2 texCoord;
+                    skipSpaces(cur, end);
+                    if (parseFloat(cur, end, texCoord.x))
+                    {
+                        skipSpaces(cur, end);
+                        parseFloat(cur, end, texCoord.y);
+                        mesh.texCoords.push_back(texCoord);
+                    }
+                }
+            }
+            else if (cur[0] == 'f' && cur + 1 < end && (cur[1] == ' ' || cur[1] == '\t'))
+            {
+                cur += 2;
+                parseFace(cur, end, chunk);
+            }
+
+            skipLine(cur, end);
+        }
+
+        mesh.min = minPoint;
+        mesh.max = maxPoint;
+    }
+
+    // Runs job(i) for every i in [0, count) on up to threadCount threads.
+    template <typename Job>
+    void parallelFor(size_t count, unsigned threadCount, Job job)
+    {
+        if (threadCount <= 1 || count <= 1)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                job(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < count; i = next++)
+            {
+                job(i);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned t = 1; t < threadCount && t < count; t++)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    template <typename T>
+    void copyInto(std::vector<T>& dst, size_t offset, const std::vector<T>& src)
+    {
+        if (!src.empty())
+        {
+            std::memcpy(dst.data() + offset, src.data(), src.size() * sizeof(T));
+        }
+    }
+}
+
+bool loadObj(const std::string& filename, ObjMesh& mesh, unsigned threadCount)
+{
+    mesh = ObjMesh();
+
+    MappedFile file(filename);
+    if (!file.isOpen())
+    {
+        std::cerr << "Can't open the file " << filename << std::endl;
+        return false;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Split the file at newline boundaries. Small files are not worth the
+    // thread start-up cost; big ones get a few chunks per thread so uneven
+    // lines (faces vs. vertices) still balance out.
+    const size_t minChunkSize = 1 << 20;
+    size_t chunkCount = std::min<size_t>((size_t)threadCount * 4, file.size() / minChunkSize);
+    chunkCount = std::max<size_t>(chunkCount, 1);
+
+    std::vector<const char*> bounds;
+    bounds.push_back(file.data());
+    for (size_t i = 1; i < chunkCount; i++)
+    {
+        const char* split = file.data() + file.size() * i / chunkCount;
+        if (split < bounds.back())
+        {
+            split = bounds.back();
+        }
+        while (split < file.end() && *split != '\n')
+        {
+            split++;
+        }
+        if (split < file.end())
+        {
+            split++;
+        }
+        bounds.push_back(split);
+    }
+    bounds.push_back(file.end());
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    parallelFor(chunkCount, threadCount, [&](size_t i) {
+        parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    if (chunkCount == 1)
+    {
+        mesh = std::move(chunks[0].mesh);
+    }
+    else
+    {
+        // Prefix sums give each chunk its offset in the stitched arrays.
+        std::vector<size_t> pointOffsets(chunkCount + 1, 0);
+        std::vector<size_t> normalOffsets(chunkCount + 1, 0);
+        std::vector<size_t> texCoordOffsets(chunkCount + 1, 0);
+        std::vector<size_t> cornerOffsets(chunkCount + 1, 0);
+        glm::vec3 minPoint(FLT_MAX), maxPoint(-FLT_MAX);
+        for (size_t i = 0; i < chunkCount; i++)
+        {
+            const ObjMesh& part = chunks[i].mesh;
+            pointOffsets[i + 1] = pointOffsets[i] + part.points.size();
+            normalOffsets[i + 1] = normalOffsets[i] + part.normals.size();
+            texCoordOffsets[i + 1] = texCoordOffsets[i] + part.texCoords.size();
+            cornerOffsets[i + 1] = cornerOffsets[i] + part.vertexIndices.size();
+            minPoint = glm::min(minPoint, part.min);
+            maxPoint = glm::max(maxPoint, part.max);
+        }
+
+        mesh.points.resize(pointOffsets[chunkCount]);
+        mesh.normals.resize(normalOffsets[chunkCount]);
+        mesh.texCoords.resize(texCoordOffsets[chunkCount]);
+        mesh.vertexIndices.resize(cornerOffsets[chunkCount]);
+        mesh.texCoordIndices.resize(cornerOffsets[chunkCount]);
+        mesh.normalIndices.resize(cornerOffsets[chunkCount]);
+        mesh.min = minPoint;
+        mesh.max = maxPoint;
+
+        parallelFor(chunkCount, threadCount, [&](size_t i) {
+            ObjChunk& chunk = chunks[i];
+            const ObjMesh& part = chunk.mesh;
+            size_t corner = cornerOffsets[i];
+
+            copyInto(mesh.points, pointOffsets[i], part.points);
+            copyInto(mesh.normals, normalOffsets[i], part.normals);
+            copyInto(mesh.texCoords, texCoordOffsets[i], part.texCoords);
+            copyInto(mesh.vertexIndices, corner, part.vertexIndices);
+            copyInto(mesh.texCoordIndices, corner, part.texCoordIndices);
+            copyInto(mesh.normalIndices, corner, part.normalIndices);
+
+            for (size_t position : chunk.relativeVertices)
+            {
+                mesh.vertexIndices[corner + position] += (int)pointOffsets[i];
+            }
+            for (size_t position : chunk.relativeTexCoords)
+            {
+                mesh.texCoordIndices[corner + position] += (int)texCoordOffsets[i];
+            }
+            for (size_t position : chunk.relativeNormals)
+            {
+                mesh.normalIndices[corner + position] += (int)normalOffsets[i];
+            }
+
+            chunk.mesh = ObjMesh();
+        });
+    }
+
+    if (mesh.points.empty())
+    {
+        mesh.min = mesh.max = glm::vec3(0.0f);
+    }
+
+    return true;
+}
+
+void normalizeObj(ObjMesh& mesh, float radius)
+{
+    if (mesh.points.empty())
+    {
+        return;
+    }
+
+    // Find max distance away from center
+    glm::vec3 center = (mesh.max + mesh.min) / 2.0f;
+    glm::vec3 halfExtent = (mesh.max - mesh.min) / 2.0f;
+    float maxDist = glm::max(halfExtent.x, glm::max(halfExtent.y, halfExtent.z));
+    float scale = maxDist > 0.0f ? radius / maxDist : 1.0f;
+
+    // Normalizing scale
+    for (glm::vec3& point : mesh.points)
+    {
+        point = (point - center) * scale;
+    }
+
+    mesh.min = (mesh.min - center) * scale;
+    mesh.max = (mesh.max - center) * scale;
+}
@@ -0,0 +1,34 @@
+#ifndef _OBJ_LOADER_H_
+#define _OBJ_LOADER_H_
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+
+// Flat arrays parsed out of an OBJ file. Faces are triangulated as fans, and
+// every triangle corner gets one entry in each of the index arrays (-1 when
+// the face does not reference that attribute). Indices are zero based.
+struct ObjMesh
+{
+    std::vector<glm::vec3> points;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<int> vertexIndices;
+    std::vector<int> texCoordIndices;
+    std::vector<int> normalIndices;
+    // Bounding box of points, filled in while parsing.
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Memory maps filename and parses its v/vn/vt/f records in place. Large files
+// are split at line boundaries and parsed on threadCount threads (0 means one
+// per hardware thread). Returns false (leaving mesh empty) if the file can't
+// be opened.
+bool loadObj(const std::string& filename, ObjMesh& mesh, unsigned threadCount = 0);
+
+// Centers the points on their bounding box and scales them so the largest
+// half extent equals radius. Bounds are updated to match.
+void normalizeObj(ObjMesh& mesh, float radius = 7.5f);
+
+#endif
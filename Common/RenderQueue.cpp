@@ -0,0 +1,86 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+RenderQueue::RenderQueue()
+    : eye(0.0f)
+{
+    std::memset(&last, 0, sizeof(last));
+}
+
+void RenderQueue::push(const DrawPacket& packet)
+{
+    // Positive floats sort the same as their bit patterns.
+    uint32_t depthBits;
+    std::memcpy(&depthBits, &packet.depth, sizeof(depthBits));
+
+    Entry entry;
+    entry.key = ((uint64_t)(packet.program & 0xFFFF) << 48)
+              | ((uint64_t)(packet.vao & 0xFFFF) << 32)
+              | depthBits;
+    entry.packet = (uint32_t)packets.size();
+    entries.push_back(entry);
+    packets.push_back(packet);
+}
+
+void RenderQueue::submit(bool keep)
+{
+    std::memset(&last, 0, sizeof(last));
+    std::sort(entries.begin(), entries.end());
+
+    ShaderProgram* program = nullptr;
+    GLuint vao = 0;
+    bool bound = false;
+    for (const Entry& entry : entries)
+    {
+        const DrawPacket& packet = packets[entry.packet];
+        if (!program || program->id() != packet.program)
+        {
+            program = &ShaderProgram::get(packet.program);
+            program->use();
+            last.programBinds++;
+        }
+        if (!bound || vao != packet.vao)
+        {
+            vao = packet.vao;
+            bound = true;
+            glBindVertexArray(vao);
+            last.vaoBinds++;
+        }
+
+        if (packet.instanceCount == 0)
+        {
+            program->set("model", packet.model);
+        }
+        if (packet.bindMaterial)
+        {
+            packet.bindMaterial(*program, packet.material);
+        }
+
+        if (packet.instanceCount == 0)
+        {
+            glDrawElements(packet.mode, packet.count, GL_UNSIGNED_INT, (void*)packet.indexOffset);
+        }
+        else
+        {
+            glDrawElementsInstanced(packet.mode, packet.count, GL_UNSIGNED_INT, (void*)packet.indexOffset,
+                                    packet.instanceCount);
+        }
+    }
+    if (bound)
+    {
+        glBindVertexArray(0);
+    }
+
+    last.packets = (unsigned)entries.size();
+    last.programBindsSaved = last.packets - last.programBinds;
+    last.vaoBindsSaved = last.packets - last.vaoBinds;
+
+    if (keep)
+    {
+        return;
+    }
+    packets.clear();
+    entries.clear();
+}
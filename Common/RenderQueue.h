@@ -0,0 +1,84 @@
+#ifndef _RENDER_QUEUE_H_
+#define _RENDER_QUEUE_H_
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "ShaderProgram.h"
+
+// Everything needed to issue one indexed draw later.
+struct DrawPacket
+{
+    GLuint program;
+    GLuint vao;
+    GLenum mode;
+    GLsizei count;
+    // Byte offset into the VAO's element array buffer.
+    size_t indexOffset;
+    // 0 for a plain draw, which also uploads model.
+    GLsizei instanceCount;
+    glm::mat4 model;
+    // What the packet sorts by within its program and VAO, usually
+    // RenderQueue::depth of where it is drawn. Instanced draws use 0 so they
+    // go ahead of the single draws.
+    float depth;
+    // Sets the rest of the packet's uniforms and state once its program and
+    // VAO are bound. May be null.
+    void (*bindMaterial)(ShaderProgram& program, const void* material);
+    const void* material;
+};
+
+// Binds issued by the last submit, and how many a draw-as-you-go traversal
+// (one program and one VAO bind per packet) would have needed on top.
+struct RenderQueueStats
+{
+    unsigned packets;
+    unsigned programBinds;
+    unsigned vaoBinds;
+    unsigned programBindsSaved;
+    unsigned vaoBindsSaved;
+};
+
+// Collects a frame's draws and submits them sorted by program, then VAO,
+// then depth (front to back), so each program and VAO is bound once per run
+// instead of once per draw.
+class RenderQueue
+{
+private:
+    struct Entry
+    {
+        uint64_t key;
+        uint32_t packet;
+
+        bool operator<(const Entry& other) const
+        {
+            return key < other.key;
+        }
+    };
+
+    std::vector<DrawPacket> packets;
+    std::vector<Entry> entries;
+    RenderQueueStats last;
+public:
+    // Depths are measured from here.
+    glm::vec3 eye;
+
+    RenderQueue();
+    float depth(const glm::vec3& position) const { return glm::length(position - eye); }
+    void push(const DrawPacket& packet);
+    // Draws everything pushed since the last submit and empties the queue,
+    // unless keep is set so the same draws can be submitted again (into
+    // another framebuffer, say).
+    void submit(bool keep = false);
+    const RenderQueueStats& stats() const { return last; }
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "ShaderProgram.h"
+
+#include <cstdint>
+#include <cstring>
+#include <glm/gtc/type_ptr.hpp>
+
+GLuint ShaderProgram::current = 0;
+std::unordered_map<GLuint, ShaderProgram*> ShaderProgram::programs;
+
+namespace
+{
+    inline uint32_t hashName(const char* name)
+    {
+        uint32_t hash = 2166136261u;
+        for (; *name; name++)
+        {
+            hash ^= (unsigned char)*name;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+}
+
+ShaderProgram::ShaderProgram(GLuint program)
+    : program(program)
+{
+    GLint count = 0;
+    GLint maxLength = 0;
+    if (program != 0)
+    {
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    }
+
+    std::vector<char> buffer(maxLength + 1);
+    for (GLint i = 0; i < count; i++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+
+        Uniform uniform;
+        uniform.name.assign(buffer.data(), length);
+        uniform.location = glGetUniformLocation(program, uniform.name.c_str());
+        uniform.valueSize = 0;
+        // Uniforms in blocks have no location.
+        if (uniform.location < 0)
+        {
+            continue;
+        }
+        uniforms.push_back(uniform);
+
+        // Arrays are reported as "name[0]"; let plain "name" find them too.
+        size_t bracket = uniform.name.find("[0]");
+        if (bracket != std::string::npos && bracket + 3 == uniform.name.size())
+        {
+            uniform.name.resize(bracket);
+            uniforms.push_back(uniform);
+        }
+    }
+
+    size_t tableSize = 16;
+    while (tableSize < uniforms.size() * 2)
+    {
+        tableSize *= 2;
+    }
+    table.assign(tableSize, -1);
+    for (size_t i = 0; i < uniforms.size(); i++)
+    {
+        size_t slot = hashName(uniforms[i].name.c_str()) & (tableSize - 1);
+        while (table[slot] >= 0)
+        {
+            slot = (slot + 1) & (tableSize - 1);
+        }
+        table[slot] = (int)i;
+    }
+}
+
+ShaderProgram& ShaderProgram::get(GLuint program)
+{
+    auto found = programs.find(program);
+    if (found != programs.end())
+    {
+        return *found->second;
+    }
+    ShaderProgram* wrapper = new ShaderProgram(program);
+    programs[program] = wrapper;
+    return *wrapper;
+}
+
+void ShaderProgram::release(GLuint program)
+{
+    auto found = programs.find(program);
+    if (found != programs.end())
+    {
+        delete found->second;
+        programs.erase(found);
+    }
+    if (current == program)
+    {
+        glUseProgram(0);
+        current = 0;
+    }
+    glDeleteProgram(program);
+}
+
+void ShaderProgram::use()
+{
+    if (current != program)
+    {
+        glUseProgram(program);
+        current = program;
+    }
+}
+
+ShaderProgram::Uniform* ShaderProgram::find(const char* name)
+{
+    size_t mask = table.size() - 1;
+    size_t slot = hashName(name) & mask;
+    while (table[slot] >= 0)
+    {
+        Uniform& uniform = uniforms[table[slot]];
+        if (std::strcmp(uniform.name.c_str(), name) == 0)
+        {
+            return &uniform;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+GLint ShaderProgram::location(const char* name)
+{
+    Uniform* uniform = find(name);
+    return uniform ? uniform->location : -1;
+}
+
+ShaderProgram::Uniform* ShaderProgram::changed(const char* name, const void* value, size_t size)
+{
+    Uniform* uniform = find(name);
+    if (!uniform)
+    {
+        return nullptr;
+    }
+    if (uniform->valueSize == size && std::memcmp(uniform->value, value, size) == 0)
+    {
+        return nullptr;
+    }
+    std::memcpy(uniform->value, value, size);
+    uniform->valueSize = size;
+    use();
+    return uniform;
+}
+
+void ShaderProgram::set(const char* name, int value)
+{
+    if (Uniform* uniform = changed(name, &value, sizeof(value)))
+    {
+        glUniform1i(uniform->location, value);
+    }
+}
+
+void ShaderProgram::set(const char* name, float value)
+{
+    if (Uniform* uniform = changed(name, &value, sizeof(value)))
+    {
+        glUniform1f(uniform->location, value);
+    }
+}
+
+void ShaderProgram::set(const char* name, const glm::vec3& value)
+{
+    if (Uniform* uniform = changed(name, glm::value_ptr(value), sizeof(value)))
+    {
+        glUniform3fv(uniform->location, 1, glm::value_ptr(value));
+    }
+}
+
+void ShaderProgram::set(const char* name, const glm::vec4& value)
+{
+    if (Uniform* uniform = changed(name, glm::value_ptr(value), sizeof(value)))
+    {
+        glUniform4fv(uniform->location, 1, glm::value_ptr(value));
+    }
+}
+
+void ShaderProgram::set(const char* name, const glm::mat4& value)
+{
+    if (Uniform* uniform = changed(name, glm::value_ptr(value), sizeof(value)))
+    {
+        glUniformMatrix4fv(uniform->location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
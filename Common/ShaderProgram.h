@@ -0,0 +1,67 @@
+#ifndef _SHADER_PROGRAM_H_
+#define _SHADER_PROGRAM_H_
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A linked program (as returned by LoadShaders) with its active uniforms
+// looked up once, when it is first asked for. The setters remember the last
+// value sent to each uniform and skip the upload when it hasn't changed, and
+// use() skips glUseProgram when the program is already current. Everything
+// that binds programs should go through here so that stays true.
+class ShaderProgram
+{
+private:
+    struct Uniform
+    {
+        std::string name;
+        GLint location;
+        // Last value uploaded, compared byte for byte.
+        unsigned char value[sizeof(glm::mat4)];
+        size_t valueSize;
+    };
+
+    GLuint program;
+    std::vector<Uniform> uniforms;
+    // Open addressing table of indices into uniforms, keyed by name hash.
+    std::vector<int> table;
+
+    static GLuint current;
+    static std::unordered_map<GLuint, ShaderProgram*> programs;
+
+    explicit ShaderProgram(GLuint program);
+    Uniform* find(const char* name);
+    // Returns the uniform to upload to, or nullptr if it is inactive or
+    // already holds value.
+    Uniform* changed(const char* name, const void* value, size_t size);
+public:
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+    static ShaderProgram& get(GLuint program);
+    // Forgets the wrapper and deletes the program.
+    static void release(GLuint program);
+
+    GLuint id() const { return program; }
+    void use();
+    // -1 if name is not an active uniform.
+    GLint location(const char* name);
+
+    // Setters make the program current first.
+    void set(const char* name, int value);
+    void set(const char* name, float value);
+    void set(const char* name, const glm::vec3& value);
+    void set(const char* name, const glm::vec4& value);
+    void set(const char* name, const glm::mat4& value);
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef _SIMD_PATH_H_
+#define _SIMD_PATH_H_
+
+// Which instruction set the batch routines (sphere culling, cubic
+// evaluation) run on, picked once from what the CPU supports. Every path
+// gives the same results; the wider ones are only faster.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC lets any function use AVX2 intrinsics; GCC and Clang need to be told
+// which ones may, and the caller checks the CPU first.
+#if defined(SIMD_X86) && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+enum SimdPath
+{
+    SIMD_PATH_SCALAR,
+    SIMD_PATH_SSE,
+    SIMD_PATH_AVX2
+};
+
+inline bool cpuHasAvx2()
+{
+#if !defined(SIMD_X86)
+    return false;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+    // AVX registers have to be enabled by the OS as well.
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+// Fastest path this CPU supports.
+inline SimdPath bestSimdPath()
+{
+#ifdef SIMD_X86
+    static const SimdPath best = cpuHasAvx2() ? SIMD_PATH_AVX2 : SIMD_PATH_SSE;
+    return best;
+#else
+    return SIMD_PATH_SCALAR;
+#endif
+}
+
+inline const char* simdPathName(SimdPath path)
+{
+    switch (path)
+    {
+        case SIMD_PATH_SSE:
+            return "SSE";
+        case SIMD_PATH_AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+#endif
@@ -0,0 +1,219 @@
+#include "SphereBvh.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Spheres per leaf, tested one at a time once a leaf straddles a plane.
+    const uint32_t leafSize = 8;
+
+    // How much looser than a fresh build the boxes may get before refit
+    // gives up and rebuilds.
+    const float maxRefitGrowth = 2.0f;
+
+    const unsigned allPlanes = (1u << 6) - 1;
+}
+
+SphereBvh::SphereBvh()
+    : builtArea(0.0f), tested(0)
+{
+}
+
+void SphereBvh::build(const SphereSet& spheres)
+{
+    uint32_t count = (uint32_t)spheres.size();
+    order.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        order[i] = i;
+    }
+
+    nodes.clear();
+    nodes.reserve(count / leafSize * 2 + 1);
+    nodes.push_back(BvhNode());
+    split(spheres, 0, 0, count);
+    builtArea = surfaceArea();
+}
+
+void SphereBvh::split(const SphereSet& spheres, uint32_t node, uint32_t first, uint32_t count)
+{
+    nodes[node].first = first;
+    nodes[node].count = count;
+    if (count <= leafSize)
+    {
+        fitLeaf(spheres, nodes[node]);
+        return;
+    }
+
+    // Median split along the longest axis of the centers.
+    glm::vec3 low(spheres.x[order[first]], spheres.y[order[first]], spheres.z[order[first]]);
+    glm::vec3 high = low;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        glm::vec3 center(spheres.x[order[i]], spheres.y[order[i]], spheres.z[order[i]]);
+        low = glm::min(low, center);
+        high = glm::max(high, center);
+    }
+    glm::vec3 extent = high - low;
+    const std::vector<float>& axis = extent.x >= extent.y && extent.x >= extent.z ? spheres.x
+                                   : extent.y >= extent.z ? spheres.y : spheres.z;
+    uint32_t half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     [&axis](uint32_t a, uint32_t b) { return axis[a] < axis[b]; });
+
+    // Children next to each other, so one index finds both.
+    uint32_t left = (uint32_t)nodes.size();
+    nodes.push_back(BvhNode());
+    nodes.push_back(BvhNode());
+    nodes[node].first = left;
+    nodes[node].count = 0;
+    split(spheres, left, first, half);
+    split(spheres, left + 1, first + half, count - half);
+    nodes[node].min = glm::min(nodes[left].min, nodes[left + 1].min);
+    nodes[node].max = glm::max(nodes[left].max, nodes[left + 1].max);
+}
+
+void SphereBvh::fitLeaf(const SphereSet& spheres, BvhNode& node) const
+{
+    node.min = glm::vec3(0.0f);
+    node.max = glm::vec3(0.0f);
+    for (uint32_t i = node.first; i < node.first + node.count; i++)
+    {
+        uint32_t sphere = order[i];
+        glm::vec3 center(spheres.x[sphere], spheres.y[sphere], spheres.z[sphere]);
+        glm::vec3 radius(spheres.radius[sphere]);
+        node.min = i == node.first ? center - radius : glm::min(node.min, center - radius);
+        node.max = i == node.first ? center + radius : glm::max(node.max, center + radius);
+    }
+}
+
+float SphereBvh::surfaceArea() const
+{
+    float area = 0.0f;
+    for (const BvhNode& node : nodes)
+    {
+        glm::vec3 size = node.max - node.min;
+        area += size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+    return area;
+}
+
+void SphereBvh::refit(const SphereSet& spheres)
+{
+    if (spheres.size() != order.size() || order.empty())
+    {
+        build(spheres);
+        return;
+    }
+
+    // Children always come after their parent, so going backwards every
+    // child is done before the node that contains it.
+    for (size_t i = nodes.size(); i-- > 0;)
+    {
+        BvhNode& node = nodes[i];
+        if (node.count)
+        {
+            fitLeaf(spheres, node);
+        }
+        else
+        {
+            const BvhNode& left = nodes[node.first];
+            const BvhNode& right = nodes[node.first + 1];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+    }
+
+    if (surfaceArea() > builtArea * maxRefitGrowth)
+    {
+        build(spheres);
+    }
+}
+
+void SphereBvh::cull(const glm::vec4 planes[6], const SphereSet& spheres, std::vector<uint32_t>& visible)
+{
+    visible.assign((spheres.size() + 31) / 32, 0);
+    tested = 0;
+    if (spheres.size() != order.size())
+    {
+        build(spheres);
+    }
+    if (!order.empty())
+    {
+        cullNode(planes, spheres, 0, allPlanes, visible);
+    }
+}
+
+void SphereBvh::cullNode(const glm::vec4 planes[6], const SphereSet& spheres, uint32_t index,
+                         unsigned planeMask, std::vector<uint32_t>& visible)
+{
+    const BvhNode& node = nodes[index];
+    glm::vec3 center = (node.min + node.max) * 0.5f;
+    glm::vec3 extent = (node.max - node.min) * 0.5f;
+    tested++;
+
+    // Only planes the parent straddled are left in planeMask.
+    for (int p = 0; p < 6; p++)
+    {
+        if (!(planeMask & (1u << p)))
+        {
+            continue;
+        }
+        glm::vec3 normal(planes[p]);
+        float distance = glm::dot(normal, center) + planes[p].w;
+        float reach = glm::dot(glm::abs(normal), extent);
+        if (distance - reach > 0.0f)
+        {
+            return;
+        }
+        if (distance + reach <= 0.0f)
+        {
+            planeMask &= ~(1u << p);
+        }
+    }
+
+    if (!planeMask)
+    {
+        acceptNode(index, visible);
+        return;
+    }
+
+    if (node.count)
+    {
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            uint32_t sphere = order[i];
+            glm::vec3 sphereCenter(spheres.x[sphere], spheres.y[sphere], spheres.z[sphere]);
+            bool inside = true;
+            for (int p = 0; inside && p < 6; p++)
+            {
+                inside = !(planeMask & (1u << p))
+                    || glm::dot(glm::vec3(planes[p]), sphereCenter) + planes[p].w <= spheres.radius[sphere];
+            }
+            if (inside)
+            {
+                visible[sphere >> 5] |= 1u << (sphere & 31);
+            }
+        }
+        tested += node.count;
+        return;
+    }
+
+    cullNode(planes, spheres, node.first, planeMask, visible);
+    cullNode(planes, spheres, node.first + 1, planeMask, visible);
+}
+
+void SphereBvh::acceptNode(uint32_t index, std::vector<uint32_t>& visible) const
+{
+    const BvhNode& node = nodes[index];
+    if (node.count)
+    {
+        for (uint32_t i = node.first; i < node.first + node.count; i++)
+        {
+            visible[order[i] >> 5] |= 1u << (order[i] & 31);
+        }
+        return;
+    }
+    acceptNode(node.first, visible);
+    acceptNode(node.first + 1, visible);
+}
@@ -0,0 +1,63 @@
+#ifndef _SPHERE_BVH_H_
+#define _SPHERE_BVH_H_
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "SphereCuller.h"
+
+// Bounding volume hierarchy of axis aligned boxes over a SphereSet, for
+// culling large numbers of spheres against a frustum. A box entirely outside
+// a plane rejects everything under it with one test, and a box entirely
+// inside one stops testing that plane further down, so a fully visible box
+// accepts everything under it without any.
+//
+// When the spheres move but keep their indices, refit() updates the boxes
+// in place; the tree is rebuilt once refitting has let it grow too loose.
+class SphereBvh
+{
+private:
+    struct BvhNode
+    {
+        glm::vec3 min;
+        glm::vec3 max;
+        // Leaves cover order[first] up to order[first + count]; inner nodes
+        // have count 0 and their children at first and first + 1.
+        uint32_t first;
+        uint32_t count;
+    };
+
+    std::vector<BvhNode> nodes;
+    // Sphere indices, grouped by leaf.
+    std::vector<uint32_t> order;
+    // Summed surface area of the boxes right after the last build.
+    float builtArea;
+    unsigned tested;
+
+    void split(const SphereSet& spheres, uint32_t node, uint32_t first, uint32_t count);
+    void fitLeaf(const SphereSet& spheres, BvhNode& node) const;
+    float surfaceArea() const;
+    void cullNode(const glm::vec4 planes[6], const SphereSet& spheres, uint32_t node,
+                  unsigned planeMask, std::vector<uint32_t>& visible);
+    void acceptNode(uint32_t node, std::vector<uint32_t>& visible) const;
+public:
+    SphereBvh();
+    void build(const SphereSet& spheres);
+    // The same spheres after moving; rebuilds if they don't match the tree
+    // or it has grown too loose.
+    void refit(const SphereSet& spheres);
+    // Same result as cullSpheres.
+    void cull(const glm::vec4 planes[6], const SphereSet& spheres, std::vector<uint32_t>& visible);
+    size_t size() const
+    {
+        return order.size();
+    }
+    // Boxes and spheres tested against the frustum by the last cull.
+    unsigned lastTested() const
+    {
+        return tested;
+    }
+};
+
+#endif
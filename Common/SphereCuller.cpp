@@ -0,0 +1,134 @@
+#include "SphereCuller.h"
+
+namespace
+{
+    inline bool sphereVisible(const glm::vec4 planes[6], float x, float y, float z, float radius)
+    {
+        for (int p = 0; p < 6; p++)
+        {
+            if (planes[p].x * x + planes[p].y * y + planes[p].z * z + planes[p].w > radius)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Spheres from first on, one at a time.
+    void cullScalar(const glm::vec4 planes[6], const SphereSet& spheres, size_t first,
+                    std::vector<uint32_t>& visible)
+    {
+        for (size_t i = first; i < spheres.size(); i++)
+        {
+            if (sphereVisible(planes, spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]))
+            {
+                visible[i >> 5] |= 1u << (i & 31);
+            }
+        }
+    }
+
+#ifdef SIMD_X86
+    // Returns the first sphere left for the scalar tail.
+    size_t cullSse(const glm::vec4 planes[6], const SphereSet& spheres, std::vector<uint32_t>& visible)
+    {
+        __m128 nx[6], ny[6], nz[6], nw[6];
+        for (int p = 0; p < 6; p++)
+        {
+            nx[p] = _mm_set1_ps(planes[p].x);
+            ny[p] = _mm_set1_ps(planes[p].y);
+            nz[p] = _mm_set1_ps(planes[p].z);
+            nw[p] = _mm_set1_ps(planes[p].w);
+        }
+
+        size_t count = spheres.size() & ~(size_t)3;
+        for (size_t i = 0; i < count; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(&spheres.x[i]);
+            __m128 y = _mm_loadu_ps(&spheres.y[i]);
+            __m128 z = _mm_loadu_ps(&spheres.z[i]);
+            __m128 radius = _mm_loadu_ps(&spheres.radius[i]);
+
+            __m128 outside = _mm_setzero_ps();
+            for (int p = 0; p < 6; p++)
+            {
+                // Summed in the same order as sphereVisible so both agree
+                // on spheres touching a plane.
+                __m128 distance = _mm_add_ps(_mm_mul_ps(x, nx[p]), _mm_mul_ps(y, ny[p]));
+                distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(z, nz[p])), nw[p]);
+                outside = _mm_or_ps(outside, _mm_cmpgt_ps(distance, radius));
+            }
+            // i is a multiple of 4, so the four bits never straddle a word.
+            uint32_t mask = ~(uint32_t)_mm_movemask_ps(outside) & 0xF;
+            visible[i >> 5] |= mask << (i & 31);
+        }
+        return count;
+    }
+
+    TARGET_AVX2 size_t cullAvx2(const glm::vec4 planes[6], const SphereSet& spheres, std::vector<uint32_t>& visible)
+    {
+        __m256 nx[6], ny[6], nz[6], nw[6];
+        for (int p = 0; p < 6; p++)
+        {
+            nx[p] = _mm256_set1_ps(planes[p].x);
+            ny[p] = _mm256_set1_ps(planes[p].y);
+            nz[p] = _mm256_set1_ps(planes[p].z);
+            nw[p] = _mm256_set1_ps(planes[p].w);
+        }
+
+        size_t count = spheres.size() & ~(size_t)7;
+        for (size_t i = 0; i < count; i += 8)
+        {
+            __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+            __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+            __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+            __m256 radius = _mm256_loadu_ps(&spheres.radius[i]);
+
+            __m256 outside = _mm256_setzero_ps();
+            for (int p = 0; p < 6; p++)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(x, nx[p]), _mm256_mul_ps(y, ny[p]));
+                distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(z, nz[p])), nw[p]);
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, radius, _CMP_GT_OQ));
+            }
+            uint32_t mask = ~(uint32_t)_mm256_movemask_ps(outside) & 0xFF;
+            visible[i >> 5] |= mask << (i & 31);
+        }
+        return count;
+    }
+#endif
+}
+
+void SphereSet::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+}
+
+void SphereSet::push(const glm::vec3& center, float radius)
+{
+    x.push_back(center.x);
+    y.push_back(center.y);
+    z.push_back(center.z);
+    this->radius.push_back(radius);
+}
+
+void cullSpheres(const glm::vec4 planes[6], const SphereSet& spheres, std::vector<uint32_t>& visible,
+                 SimdPath path)
+{
+    visible.assign((spheres.size() + 31) / 32, 0);
+
+    size_t first = 0;
+#ifdef SIMD_X86
+    if (path == SIMD_PATH_AVX2 && bestSimdPath() == SIMD_PATH_AVX2)
+    {
+        first = cullAvx2(planes, spheres, visible);
+    }
+    else if (path != SIMD_PATH_SCALAR)
+    {
+        first = cullSse(planes, spheres, visible);
+    }
+#endif
+    cullScalar(planes, spheres, first, visible);
+}
@@ -0,0 +1,38 @@
+#ifndef _SPHERE_CULLER_H_
+#define _SPHERE_CULLER_H_
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "SimdPath.h"
+
+// Bounding spheres stored one component per array, so consecutive spheres
+// load straight into SIMD lanes.
+struct SphereSet
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+
+    size_t size() const
+    {
+        return x.size();
+    }
+    void clear();
+    void push(const glm::vec3& center, float radius);
+};
+
+// Tests every sphere against the six planes, given as (outward normal,
+// offset) like DrawContext::frustumPlanes. Bit i % 32 of visible[i / 32] is
+// set when sphere i is not entirely outside any of them.
+void cullSpheres(const glm::vec4 planes[6], const SphereSet& spheres, std::vector<uint32_t>& visible,
+                 SimdPath path = bestSimdPath());
+
+inline bool isVisible(const std::vector<uint32_t>& visible, size_t i)
+{
+    return (visible[i >> 5] >> (i & 31)) & 1;
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "StreamBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+StreamBuffer::StreamBuffer(size_t size, int regionCount)
+    : size(size), regionCount(regionCount), region(regionCount - 1), mapped(nullptr), data(size),
+      fences(regionCount, nullptr), staleBegin(regionCount, 0), staleEnd(regionCount, 0)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+#ifndef __APPLE__
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage)
+    {
+        // Coherent, so copies are seen by the next draw without a flush.
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size * regionCount, NULL, flags);
+        mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size * regionCount, flags);
+    }
+#endif
+    if (!mapped)
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, size * regionCount, NULL, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (GLsync fence: fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    if (mapped)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void StreamBuffer::write(size_t offset, const void* source, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    memcpy(data.data() + offset, source, count);
+    for (int i = 0; i < regionCount; i++)
+    {
+        if (staleBegin[i] >= staleEnd[i])
+        {
+            staleBegin[i] = offset;
+            staleEnd[i] = offset + count;
+        }
+        else
+        {
+            staleBegin[i] = std::min(staleBegin[i], offset);
+            staleEnd[i] = std::max(staleEnd[i], offset + count);
+        }
+    }
+}
+
+void StreamBuffer::wait(int region)
+{
+    if (!fences[region])
+    {
+        return;
+    }
+    // The fence went in regionCount - 1 frames ago, so this is normally
+    // already signaled. Flush in case it was never sent.
+    GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    while (result == GL_TIMEOUT_EXPIRED)
+    {
+        result = glClientWaitSync(fences[region], 0, 1000000000);
+    }
+    glDeleteSync(fences[region]);
+    fences[region] = nullptr;
+}
+
+size_t StreamBuffer::begin()
+{
+    region = (region + 1) % regionCount;
+    size_t base = size * region;
+    if (staleBegin[region] < staleEnd[region])
+    {
+        wait(region);
+        size_t offset = staleBegin[region];
+        size_t count = staleEnd[region] - offset;
+        if (mapped)
+        {
+            memcpy(mapped + base + offset, data.data() + offset, count);
+        }
+        else
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, base + offset, count, data.data() + offset);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        staleBegin[region] = 0;
+        staleEnd[region] = 0;
+    }
+    return base;
+}
+
+void StreamBuffer::end()
+{
+    if (fences[region])
+    {
+        glDeleteSync(fences[region]);
+    }
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
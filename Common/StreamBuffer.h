@@ -0,0 +1,56 @@
+#ifndef _STREAM_BUFFER_H_
+#define _STREAM_BUFFER_H_
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#include <cstddef>
+#include <vector>
+
+// size bytes of vertex data that change now and then, kept in a GL buffer
+// allocated once and split into several regions, each a full copy. A frame
+// draws from one region while the GPU may still be reading the ones before
+// it, so writes only land in a region once its last frame is fenced off and
+// never wait on draws in flight.
+//
+// Writes go to a copy in memory and reach each region as it comes round.
+// With ARB_buffer_storage the buffer stays mapped and they are copied
+// straight in; otherwise they go through glBufferSubData.
+class StreamBuffer
+{
+private:
+    GLuint buffer;
+    size_t size;
+    int regionCount;
+    int region;
+    char* mapped;
+    std::vector<char> data;
+    // Fence after the last frame that drew from each region.
+    std::vector<GLsync> fences;
+    // Bytes written since each region was last brought up to date, as a
+    // range; empty when begin >= end.
+    std::vector<size_t> staleBegin;
+    std::vector<size_t> staleEnd;
+
+    void wait(int region);
+public:
+    StreamBuffer(size_t size, int regionCount = 3);
+    ~StreamBuffer();
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    GLuint id() const { return buffer; }
+    bool persistent() const { return mapped != nullptr; }
+    void write(size_t offset, const void* source, size_t count);
+    // Moves to the next region, brings it up to date and returns its byte
+    // offset in the buffer. Draw from there until end().
+    size_t begin();
+    // Fences the region after the frame's draws from it.
+    void end();
+};
+
+#endif
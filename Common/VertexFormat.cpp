@@ -0,0 +1,112 @@
+#include "VertexFormat.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    inline int16_t toSnorm16(float value)
+    {
+        if (value > 1.0f)
+        {
+            value = 1.0f;
+        }
+        else if (value < -1.0f)
+        {
+            value = -1.0f;
+        }
+        return (int16_t)std::lround(value * 32767.0f);
+    }
+
+    inline float signNotZero(float value)
+    {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    // Projects the unit normal onto an octahedron and unfolds it into the
+    // [-1, 1] square.
+    inline glm::vec2 encodeOctahedral(glm::vec3 n)
+    {
+        float length = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+        if (length == 0.0f)
+        {
+            return glm::vec2(0.0f, 0.0f);
+        }
+        n /= length;
+        if (n.z < 0.0f)
+        {
+            return glm::vec2((1.0f - std::fabs(n.y)) * signNotZero(n.x),
+                             (1.0f - std::fabs(n.x)) * signNotZero(n.y));
+        }
+        return glm::vec2(n.x, n.y);
+    }
+}
+
+size_t vertexStride(VertexFormat format)
+{
+    switch (format)
+    {
+    case VERTEX_FORMAT_INTERLEAVED:
+        return 6 * sizeof(float);
+    case VERTEX_FORMAT_QUANTIZED:
+        return 6 * sizeof(int16_t);
+    default:
+        return 3 * sizeof(float);
+    }
+}
+
+void packVertices(const MeshCache& mesh, VertexFormat format, PackedVertices& result)
+{
+    result = PackedVertices();
+    result.format = format;
+    if (format == VERTEX_FORMAT_SEPARATE)
+    {
+        return;
+    }
+
+    size_t count = mesh.positionCount();
+    size_t stride = vertexStride(format);
+    const glm::vec3* positions = mesh.positions();
+    const glm::vec3* normals = mesh.normals();
+    const glm::vec3 missingNormal(0.0f, 0.0f, 1.0f);
+
+    result.data.resize(count * stride);
+    unsigned char* out = result.data.data();
+
+    if (format == VERTEX_FORMAT_INTERLEAVED)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const glm::vec3& normal = i < mesh.normalCount() ? normals[i] : missingNormal;
+            std::memcpy(out + i * stride, &positions[i], sizeof(glm::vec3));
+            std::memcpy(out + i * stride + sizeof(glm::vec3), &normal, sizeof(glm::vec3));
+        }
+        return;
+    }
+
+    // Map the bounding box onto [-1, 1] on each axis.
+    glm::vec3 min = mesh.min();
+    glm::vec3 max = mesh.max();
+    result.offset = (min + max) * 0.5f;
+    result.scale = (max - min) * 0.5f;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (result.scale[axis] <= 0.0f)
+        {
+            result.scale[axis] = 1.0f;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 position = (positions[i] - result.offset) / result.scale;
+        glm::vec2 normal = encodeOctahedral(i < mesh.normalCount() ? normals[i] : missingNormal);
+
+        int16_t packed[6] = {
+            toSnorm16(position.x), toSnorm16(position.y), toSnorm16(position.z), 0,
+            toSnorm16(normal.x), toSnorm16(normal.y)
+        };
+        std::memcpy(out + i * stride, packed, sizeof(packed));
+    }
+}
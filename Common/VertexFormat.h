@@ -0,0 +1,84 @@
+#ifndef _VERTEX_FORMAT_H_
+#define _VERTEX_FORMAT_H_
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "MeshCache.h"
+#include "ShaderProgram.h"
+
+// How positions (attribute 0) and normals (attribute 1) are laid out in the
+// vertex buffers.
+enum VertexFormat
+{
+    // Two float arrays in separate buffers, 24 bytes per vertex.
+    VERTEX_FORMAT_SEPARATE,
+    // Float position and normal interleaved in one buffer, 24 bytes.
+    VERTEX_FORMAT_INTERLEAVED,
+    // One buffer of 16 bit normalized positions across the bounding box
+    // (padded to 8 bytes) and octahedral normals in two 16 bit normalized
+    // values, 12 bytes. The shader rebuilds them with positionScale,
+    // positionOffset and decodeOctahedral.
+    VERTEX_FORMAT_QUANTIZED
+};
+
+// Vertices packed for one format. VERTEX_FORMAT_SEPARATE uses the mesh
+// arrays as they are, so data stays empty.
+struct PackedVertices
+{
+    VertexFormat format = VERTEX_FORMAT_SEPARATE;
+    std::vector<unsigned char> data;
+    // Quantized positions decode to position * scale + offset.
+    glm::vec3 scale = glm::vec3(1.0f);
+    glm::vec3 offset = glm::vec3(0.0f);
+};
+
+size_t vertexStride(VertexFormat format);
+
+void packVertices(const MeshCache& mesh, VertexFormat format, PackedVertices& result);
+
+// Points attributes 0 and 1 of the bound VAO at the vertex buffers. The
+// interleaved formats only use positionBuffer.
+inline void setVertexAttributes(VertexFormat format, GLuint positionBuffer, GLuint normalBuffer)
+{
+    GLsizei stride = (GLsizei)vertexStride(format);
+
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    switch (format)
+    {
+    case VERTEX_FORMAT_SEPARATE:
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, normalBuffer);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, 0);
+        break;
+    case VERTEX_FORMAT_INTERLEAVED:
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, 0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(GLfloat)));
+        break;
+    case VERTEX_FORMAT_QUANTIZED:
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, 0);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)(4 * sizeof(GLshort)));
+        break;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Tells a program using the decoding vertex shader how to read the packed
+// vertices.
+inline void setVertexDecodeUniforms(ShaderProgram& program, const PackedVertices& vertices)
+{
+    program.set("quantized", vertices.format == VERTEX_FORMAT_QUANTIZED ? 1 : 0);
+    program.set("positionScale", vertices.scale);
+    program.set("positionOffset", vertices.offset);
+}
+
+#endif
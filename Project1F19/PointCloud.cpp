@@ -1,7 +1,7 @@
 #include "PointCloud.h"
 
-PointCloud::PointCloud(std::string objFilename, std::vector<glm::vec3> points, GLfloat pointSize)
-	: pointSize(pointSize), points(points)
+PointCloud::PointCloud(std::string objFilename, GLfloat pointSize, AsyncMeshLoader* loader)
+	: objFilename(objFilename), pointsNum(0), pointSize(pointSize), uploading(false), ready(false)
 {
 	// Set the model matrix to an identity matrix. 
 	model = glm::mat4(1);
@@ -9,6 +9,7 @@ PointCloud::PointCloud(std::string objFilename, std::vector<glm::vec3> points, G
 	color = glm::vec3(1, 0, 0);
 
 	// Generate a vertex array (VAO) and a vertex buffer objects (VBO).
+	// The VBO's storage is allocated once the points have been loaded.
 	glGenVertexArrays(1, &vao);
 	glGenBuffers(1, &vbo);
 
@@ -17,9 +18,6 @@ PointCloud::PointCloud(std::string objFilename, std::vector<glm::vec3> points, G
 
 	// Bind to the first VBO. We will use it to store the points.
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	// Pass in the data.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(),
-		points.data(), GL_STATIC_DRAW);
 	// Enable vertex attribute 0. 
 	// We will be able to access points through it.
 	glEnableVertexAttribArray(0);
@@ -30,7 +28,45 @@ PointCloud::PointCloud(std::string objFilename, std::vector<glm::vec3> points, G
 	// Unbind from the VAO.
 	glBindVertexArray(0);
 
-	std::cout << "Initialized " + objFilename << std::endl;
+	// Placeholder box, sized to the normalized radius until the real bounds
+	// are known.
+	const GLuint boxEdges[] = {
+		0, 1, 1, 3, 3, 2, 2, 0,
+		4, 5, 5, 7, 7, 6, 6, 4,
+		0, 4, 1, 5, 2, 6, 3, 7
+	};
+	glGenVertexArrays(1, &boxVao);
+	glGenBuffers(1, &boxVbo);
+	glGenBuffers(1, &boxEbo);
+
+	glBindVertexArray(boxVao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, boxVbo);
+	glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(glm::vec3), NULL, GL_DYNAMIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boxEbo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(boxEdges), boxEdges, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	setBox(glm::vec3(-7.5f), glm::vec3(7.5f));
+
+	// Parse the points, centered and scaled to a radius of 7.5.
+	if (loader)
+	{
+		request = loader->load(objFilename, MESH_LAYOUT_POINTS, 7.5f);
+	}
+	else
+	{
+		request = std::make_shared<MeshLoadRequest>(objFilename, MESH_LAYOUT_POINTS, 7.5f);
+		request->run();
+
+		size_t unlimited = SIZE_MAX;
+		finishLoading(unlimited);
+	}
 }
 
 PointCloud::~PointCloud() 
@@ -38,16 +74,82 @@ PointCloud::~PointCloud()
 	// Delete the VBO and the VAO.
 	glDeleteBuffers(1, &vbo);
 	glDeleteVertexArrays(1, &vao);
+
+	glDeleteBuffers(1, &boxVbo);
+	glDeleteBuffers(1, &boxEbo);
+	glDeleteVertexArrays(1, &boxVao);
+}
+
+void PointCloud::setBox(glm::vec3 min, glm::vec3 max)
+{
+	glm::vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		corners[i] = glm::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, boxVbo);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(corners), corners);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void PointCloud::finishLoading(size_t& budget)
+{
+	if (ready || !request)
+	{
+		return;
+	}
+
+	switch (request->state())
+	{
+	case MeshLoadRequest::LOADING:
+		return;
+	case MeshLoadRequest::FAILED:
+		// Keep drawing the placeholder.
+		request.reset();
+		return;
+	default:
+		break;
+	}
+
+	MeshCache& mesh = request->mesh;
+	if (!uploading)
+	{
+		setBox(mesh.min(), mesh.max());
+		upload.start(vbo, mesh.positions(), sizeof(glm::vec3) * mesh.positionCount());
+		uploading = true;
+	}
+
+	upload.step(budget);
+	if (!upload.done())
+	{
+		return;
+	}
+
+	pointsNum = mesh.positionCount();
+	ready = true;
+	request.reset();
+
+	std::cout << "Initialized " + objFilename << std::endl;
 }
 
 void PointCloud::draw()
 {
+	if (!ready)
+	{
+		// Draw the bounding box until the points are ready.
+		glBindVertexArray(boxVao);
+		glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
+		glBindVertexArray(0);
+		return;
+	}
+
 	// Bind to the VAO.
 	glBindVertexArray(vao);
 	// Set point size.
 	glPointSize(pointSize);
 	// Draw points 
-	glDrawArrays(GL_POINTS, 0, points.size());
+	glDrawArrays(GL_POINTS, 0, pointsNum);
 	// Unbind from the VAO.
 	glBindVertexArray(0);
 }
@@ -65,7 +167,7 @@ void PointCloud::updatePointSize(GLfloat size)
 	// Set point size.
 	glPointSize(pointSize);
 	// Draw points 
-	glDrawArrays(GL_POINTS, 0, points.size());
+	glDrawArrays(GL_POINTS, 0, pointsNum);
 }
 
 void PointCloud::spin(float deg)
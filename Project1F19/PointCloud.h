@@ -12,21 +12,37 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <memory>
+#include <cstdint>
 
 #include "Object.h"
+#include "../Common/AsyncMeshLoader.h"
+#include "../Common/BufferUpload.h"
 
 class PointCloud : public Object
 {
 private:
-	std::vector<glm::vec3> points;
+	std::string objFilename;
+	int pointsNum;
 	GLuint vao, vbo;
 	GLfloat pointSize;
+	// Bounding box drawn in place of the points until they are uploaded.
+	GLuint boxVao, boxVbo, boxEbo;
+	std::shared_ptr<MeshLoadRequest> request;
+	BufferUpload upload;
+	bool uploading;
+	bool ready;
+
+	void setBox(glm::vec3 min, glm::vec3 max);
 public:
-	PointCloud(std::string objFilename, std::vector<glm::vec3> points, GLfloat pointSize);
+	// Without a loader the points are loaded and uploaded before returning.
+	PointCloud(std::string objFilename, GLfloat pointSize, AsyncMeshLoader* loader = nullptr);
 	~PointCloud();
 
 	void draw();
 	void update();
+	void finishLoading(size_t& budget);
+	bool isReady() { return ready; }
 
 	void updatePointSize(GLfloat size);
 	void spin(float deg);
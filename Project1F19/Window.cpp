@@ -12,6 +12,11 @@ PointCloud* Window::bunnyPoints;
 PointCloud* Window::dragonPoints;
 PointCloud* Window::bearPoints;
 
+// Loads the point clouds in the background so the first frame isn't held up.
+AsyncMeshLoader* Window::loader;
+// Bytes of point data uploaded to the GPU per frame.
+size_t Window::uploadBudget = 8 << 20;
+
 // The object currently displaying.
 Object* Window::currentObj; 
 
@@ -55,125 +60,23 @@ bool Window::initializeProgram() {
 
 bool Window::initializeObjects()
 {
-	// Initialzie PointClouds to 3 obj files.
-	bunnyPoints = new PointCloud("bunny", objFileToPoints("bunny.obj"), 10);
-	dragonPoints = new PointCloud("dragon", objFileToPoints("dragon.obj"), 10);
-	bearPoints = new PointCloud("bear", objFileToPoints("bear.obj"), 10);
+	// Initialzie PointClouds to 3 obj files. They draw as bounding boxes
+	// until their points have loaded.
+	loader = new AsyncMeshLoader();
+	bunnyPoints = new PointCloud("bunny.obj", 10, loader);
+	dragonPoints = new PointCloud("dragon.obj", 10, loader);
+	bearPoints = new PointCloud("bear.obj", 10, loader);
 
 	// Set bunnyPoints to be the first object to appear.
 	currentObj = bunnyPoints;
 	return true;
 }
 
-std::vector<glm::vec3> Window::objFileToPoints(std::string fileName)
-{
-	std::ifstream objFile(fileName); // The obj file we are reading.
-	std::vector<glm::vec3> points;
-
-	// Check whether the file can be opened.
-	if (objFile.is_open())
-	{
-		std::string line; // A line in the file.
-
-		// Read lines from the file.
-		while (std::getline(objFile, line))
-		{
-			// Turn the line into a string stream for processing.
-			std::stringstream ss;
-			ss << line;
-
-			// Read the first word of the line.
-			std::string label;
-			ss >> label;
-
-			// If the line is about vertex (starting with a "v").
-			if (label == "v")
-			{
-				// Read the later three float numbers and use them as the 
-				// coordinates.
-				glm::vec3 point;
-				ss >> point.x >> point.y >> point.z;
-
-				// Process the point.
-				points.push_back(point);
-			}
-		}
-	}
-	else
-	{
-		std::cerr << "Can't open the file " << fileName << std::endl;
-	}
-
-	objFile.close();
-
-	// Find center point of model
-	float minX = points[0].x, minY = points[0].y, minZ = points[0].z;
-	float maxX = points[0].x, maxY = points[0].y, maxZ = points[0].z;
-
-	for (std::vector<glm::vec3>::size_type i = 1; i < points.size(); i++)
-	{
-		if (points[i].x < minX)
-		{
-			minX = points[i].x;
-		}
-		if (points[i].y < minY)
-		{
-			minY = points[i].y;
-		}
-		if (points[i].z < minZ)
-		{
-			minZ = points[i].z;
-		}
-		if (points[i].x > maxX)
-		{
-			maxX = points[i].x;
-		}
-		if (points[i].y > maxY)
-		{
-			maxY = points[i].y;
-		}
-		if (points[i].z > maxZ)
-		{
-			maxZ = points[i].z;
-		}
-	}
-
-	// Find max distance away from center
-	float avgX = (maxX - minX) / 2, avgY = (maxY - minY) / 2, avgZ = (maxZ - minZ) / 2;
-	float maxDist;
-
-	if (avgX >= avgY && avgX >= avgZ)
-	{
-		maxDist = avgX;
-	}
-	else if (avgY >= avgX && avgY >= avgZ)
-	{
-		maxDist = avgY;
-	}
-	else if (avgZ >= avgX && avgZ >= avgY)
-	{
-		maxDist = avgZ;
-	}
-
-	// Normalizing scale
-	for (std::vector<glm::vec3>::size_type i = 0; i < points.size(); i++)
-	{
-		points[i].x -= (maxX + minX) / 2;
-		points[i].x *= 7.5f / maxDist;
-		points[i].y -= (maxY + minY) / 2;
-		points[i].y *= 7.5f / maxDist;
-		points[i].z -= (maxZ + minZ) / 2;
-		points[i].z *= 7.5f / maxDist;
-	}
-
-	minX = points[0].x, minY = points[0].y, minZ = points[0].z;
-	maxX = points[0].x, maxY = points[0].y, maxZ = points[0].z;
-
-	return points;
-}
-
 void Window::cleanUp()
 {
+	// Stop loading before the point clouds go away.
+	delete loader;
+
 	// Deallcoate the objects.
 	delete bunnyPoints;
 	delete dragonPoints;
@@ -268,6 +171,13 @@ void Window::displayCallback(GLFWwindow* window)
 	// Clear the color and depth buffers.
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);	
 
+	// Upload point clouds that finished loading, the one on screen first.
+	size_t budget = uploadBudget;
+	((PointCloud*)currentObj)->finishLoading(budget);
+	bunnyPoints->finishLoading(budget);
+	dragonPoints->finishLoading(budget);
+	bearPoints->finishLoading(budget);
+
 	// Specify the values of the uniform variables we are going to use.
 	glm::mat4 model = currentObj->getModel();
 	glm::vec3 color = currentObj->getColor();
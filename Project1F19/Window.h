@@ -35,6 +35,8 @@ public:
 	static PointCloud* bearPoints;
 	static Object* currentObj;
 	static GLfloat currentSize;
+	static AsyncMeshLoader* loader;
+	static size_t uploadBudget;
 	static glm::mat4 projection;
 	static glm::mat4 view;
 	static glm::vec3 eye, center, up;
@@ -42,7 +44,6 @@ public:
 
 	static bool initializeProgram();
 	static bool initializeObjects();
-	static std::vector<glm::vec3> objFileToPoints(std::string fileName);
 	static void cleanUp();
 	static GLFWwindow* createWindow(int width, int height);
 	static void resizeCallback(GLFWwindow* window, int width, int height);
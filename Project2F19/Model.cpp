@@ -1,163 +1,71 @@
 #include "Model.h"
 
-Model::Model(std::string fileName)
+Model::Model(std::string fileName, AsyncMeshLoader* loader, VertexFormat format)
+	: indicesNum(0), format(format), uploading(false), ready(false), fileName(fileName)
 {
-	std::ifstream objFile(fileName); // The obj file we are reading.
-	std::vector<glm::vec3> points;
-	std::vector<glm::vec3> normals;
-	std::vector<glm::ivec3> faceIndices;
-
-	// Check whether the file can be opened.
-	if (objFile.is_open())
-	{
-		this->fileName = fileName;
-		std::string line; // A line in the file.
-
-		// Read lines from the file.
-		while (std::getline(objFile, line))
-		{
-			// Turn the line into a string stream for processing.
-			std::stringstream ss;
-			ss << line;
-
-			// Read the first word of the line.
-			std::string label;
-			ss >> label;
-
-			// If the line is about vertex (starting with a "v").
-			if (label == "v")
-			{
-				// Read the later three float numbers and use them as the 
-				// coordinates.
-				glm::vec3 point;
-				ss >> point.x >> point.y >> point.z;
-
-				// Process the point.
-				points.push_back(point);
-			}
-			else if (label == "vn") {
-				glm::vec3 normal;
-				ss >> normal.x >> normal.y >> normal.z;
-
-				normals.push_back(normal);
-			}
-			else if (label == "f") {
-				glm::ivec3 indices;
-				std::string v1IndexStr, v2IndexStr, v3IndexStr;
-				
-				ss >> v1IndexStr >> v2IndexStr >> v3IndexStr;
-				indices.x = atoi(v1IndexStr.c_str()) - 1;
-				indices.y = atoi(v2IndexStr.c_str()) - 1;
-				indices.z = atoi(v3IndexStr.c_str()) - 1;
-
-				faceIndices.push_back(indices);
-			}
-		}
-	}
-	else
-	{
-		std::cerr << "Can't open the file " << fileName << std::endl;
-	}
-
-	objFile.close();
-
-	// Find center point of model
-	float minX = points[0].x, minY = points[0].y, minZ = points[0].z;
-	float maxX = points[0].x, maxY = points[0].y, maxZ = points[0].z;
-
-	for (std::vector<glm::vec3>::size_type i = 1; i < points.size(); i++)
-	{
-		if (points[i].x < minX)
-		{
-			minX = points[i].x;
-		}
-		if (points[i].y < minY)
-		{
-			minY = points[i].y;
-		}
-		if (points[i].z < minZ)
-		{
-			minZ = points[i].z;
-		}
-		if (points[i].x > maxX)
-		{
-			maxX = points[i].x;
-		}
-		if (points[i].y > maxY)
-		{
-			maxY = points[i].y;
-		}
-		if (points[i].z > maxZ)
-		{
-			maxZ = points[i].z;
-		}
-	}
-
-	// Find max distance away from center
-	float avgX = (maxX - minX) / 2, avgY = (maxY - minY) / 2, avgZ = (maxZ - minZ) / 2;
-	float maxDist;
-
-	if (avgX >= avgY && avgX >= avgZ)
-	{
-		maxDist = avgX;
-	}
-	else if (avgY >= avgX && avgY >= avgZ)
-	{
-		maxDist = avgY;
-	}
-	else if (avgZ >= avgX && avgZ >= avgY)
-	{
-		maxDist = avgZ;
-	}
-
-	// Normalizing scale
-	for (std::vector<glm::vec3>::size_type i = 0; i < points.size(); i++)
-	{
-		points[i].x -= (maxX + minX) / 2;
-		points[i].x *= 7.5f / maxDist;
-		points[i].y -= (maxY + minY) / 2;
-		points[i].y *= 7.5f / maxDist;
-		points[i].z -= (maxZ + minZ) / 2;
-		points[i].z *= 7.5f / maxDist;
-	}
-
-	indicesNum = faceIndices.size() * 3;
-
 	// Model matrix.
 	model = glm::mat4(1.0f);
 
 	// Generate a vertex array (VAO) and two vertex buffer objects (VBO).
+	// Their storage is allocated once the mesh has been loaded.
 	glGenVertexArrays(1, &vao);
 	glGenBuffers(2, vbos);
+	glGenBuffers(1, &ebo);
 
 	// Bind to the VAO.
 	glBindVertexArray(vao);
-	
-	glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(),
-		points.data(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
 
-	glBindBuffer(GL_ARRAY_BUFFER, vbos[1]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * normals.size(),
-		normals.data(), GL_STATIC_DRAW);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
+	// The interleaved formats keep everything in the first VBO.
+	setVertexAttributes(format, vbos[0], vbos[1]);
 
-	glGenBuffers(1, &ebo);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(glm::ivec3) * faceIndices.size(), 
-		faceIndices.data(), GL_STATIC_DRAW);
 
-	// Unbind from the VBOs.
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	// Unbind from the VAO.
 	glBindVertexArray(0);
 
+	// Placeholder box, sized to the normalized radius until the real bounds
+	// are known.
+	const GLuint boxEdges[] = {
+		0, 1, 1, 3, 3, 2, 2, 0,
+		4, 5, 5, 7, 7, 6, 6, 4,
+		0, 4, 1, 5, 2, 6, 3, 7
+	};
+	glGenVertexArrays(1, &boxVao);
+	glGenBuffers(1, &boxVbo);
+	glGenBuffers(1, &boxEbo);
+
+	glBindVertexArray(boxVao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, boxVbo);
+	glBufferData(GL_ARRAY_BUFFER, 8 * sizeof(glm::vec3), NULL, GL_DYNAMIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boxEbo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(boxEdges), boxEdges, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+
+	setBox(glm::vec3(-7.5f), glm::vec3(7.5f));
+
 	ID = LoadShaders("shaders/shader.vert", "shaders/shader.frag");
 
-	printf("Finished %s\n", fileName.c_str());
+	// Parse and center the model, scaling it to a radius of 7.5. Faces
+	// share indices between points and normals, and are reordered for the
+	// vertex cache when the mesh cache is built.
+	if (loader)
+	{
+		request = loader->load(fileName, MESH_LAYOUT_SHARED_INDICES, 7.5f, true, format);
+	}
+	else
+	{
+		request = std::make_shared<MeshLoadRequest>(fileName, MESH_LAYOUT_SHARED_INDICES, 7.5f, true, format);
+		request->run();
+
+		size_t unlimited = SIZE_MAX;
+		finishLoading(unlimited);
+	}
 }
 
 Model::~Model()
@@ -167,11 +75,96 @@ Model::~Model()
 	glDeleteBuffers(1, &ebo);
 	glDeleteVertexArrays(1, &vao);
 
-	glDeleteProgram(ID);
+	glDeleteBuffers(1, &boxVbo);
+	glDeleteBuffers(1, &boxEbo);
+	glDeleteVertexArrays(1, &boxVao);
+
+	ShaderProgram::release(ID);
+}
+
+void Model::setBox(glm::vec3 min, glm::vec3 max)
+{
+	glm::vec3 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		corners[i] = glm::vec3((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, boxVbo);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(corners), corners);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Model::finishLoading(size_t& budget)
+{
+	if (ready || !request)
+	{
+		return;
+	}
+
+	switch (request->state())
+	{
+	case MeshLoadRequest::LOADING:
+		return;
+	case MeshLoadRequest::FAILED:
+		// Keep drawing the placeholder.
+		request.reset();
+		return;
+	default:
+		break;
+	}
+
+	MeshCache& mesh = request->mesh;
+	if (!uploading)
+	{
+		setBox(mesh.min(), mesh.max());
+
+		if (format == VERTEX_FORMAT_SEPARATE)
+		{
+			uploads[0].start(vbos[0], mesh.positions(), sizeof(glm::vec3) * mesh.positionCount());
+			uploads[1].start(vbos[1], mesh.normals(), sizeof(glm::vec3) * mesh.normalCount());
+		}
+		else
+		{
+			const std::vector<unsigned char>& packed = request->vertices.data;
+			uploads[0].start(vbos[0], packed.data(), packed.size());
+			uploads[1].start(vbos[1], NULL, 0);
+		}
+		uploads[2].start(ebo, mesh.indices(), sizeof(unsigned) * mesh.indexCount());
+		uploading = true;
+	}
+
+	for (BufferUpload& upload : uploads)
+	{
+		upload.step(budget);
+		if (!upload.done())
+		{
+			return;
+		}
+	}
+
+	setVertexDecodeUniforms(ShaderProgram::get(ID), request->vertices);
+
+	indicesNum = mesh.indexCount();
+	ready = true;
+	request.reset();
+
+	printf("Finished %s\n", fileName.c_str());
 }
 
 void Model::draw()
 {
+	if (!ready)
+	{
+		// Draw the bounding box until the mesh is ready. It has no normals,
+		// so give it a constant one.
+		glBindVertexArray(boxVao);
+		glVertexAttrib3f(1, 0.0f, 0.0f, 1.0f);
+		glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
+		glBindVertexArray(0);
+		return;
+	}
+
 	// Bind to the VAO.
 	glBindVertexArray(vao);
 	// Draw triangles using the indices in the second VBO, which is an 
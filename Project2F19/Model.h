@@ -13,9 +13,14 @@
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <memory>
+#include <cstdint>
 
 #include "Object.h"
 #include "shader.h"
+#include "../Common/AsyncMeshLoader.h"
+#include "../Common/BufferUpload.h"
+#include "../Common/ShaderProgram.h"
 
 class Model : public Object
 {
@@ -24,13 +29,26 @@ private:
 	GLuint vbos[2];
 	GLuint ebo;
 	int indicesNum;
+	VertexFormat format;
+	// Bounding box drawn in place of the mesh until it is uploaded.
+	GLuint boxVao, boxVbo, boxEbo;
+	std::shared_ptr<MeshLoadRequest> request;
+	BufferUpload uploads[3];
+	bool uploading;
+	bool ready;
+
+	void setBox(glm::vec3 min, glm::vec3 max);
 public:
-	Model(std::string fileName);
+	// Without a loader the mesh is loaded and uploaded before returning.
+	Model(std::string fileName, AsyncMeshLoader* loader = nullptr,
+		VertexFormat format = VERTEX_FORMAT_QUANTIZED);
 	~Model();
 	GLuint ID;
 	std::string fileName;
 
 	void draw();
+	void finishLoading(size_t& budget);
+	bool isReady() { return ready; }
 
 	void rotate(glm::vec3 lastPoint, glm::vec3 curPoint);
 	void changeSize(double offset);
@@ -12,6 +12,11 @@ Model* Window::bear;
 
 Light* Window::light;
 
+// Loads the models in the background so the first frame isn't held up.
+AsyncMeshLoader* Window::loader;
+// Bytes of mesh data uploaded to the GPU per frame.
+size_t Window::uploadBudget = 8 << 20;
+
 // The object currently displaying.
 Object* Window::currentObj; 
 
@@ -36,10 +41,12 @@ bool normalColoring = false;
 
 bool Window::initializeObjects()
 {
-	// Initialize Models from 3 obj files.
-	bunny = new Model("bunny.obj");
-	dragon = new Model("dragon.obj");
-	bear = new Model("bear.obj");
+	// Initialize Models from 3 obj files. They draw as bounding boxes until
+	// their meshes have loaded.
+	loader = new AsyncMeshLoader();
+	bunny = new Model("bunny.obj", loader);
+	dragon = new Model("dragon.obj", loader);
+	bear = new Model("bear.obj", loader);
 
 	light = new Light("sphere.obj", lightPos);
 	
@@ -53,6 +60,9 @@ bool Window::initializeObjects()
 
 void Window::cleanUp()
 {
+	// Stop loading before the models go away.
+	delete loader;
+
 	// Deallcoate the objects.
 	delete bunny;
 	delete dragon;
@@ -139,64 +149,72 @@ void Window::displayCallback(GLFWwindow* window)
 	// Clear the color and depth buffers.
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);	
 
+	// Upload meshes that finished loading, the one on screen first.
+	size_t budget = uploadBudget;
+	((Model*)currentObj)->finishLoading(budget);
+	bunny->finishLoading(budget);
+	dragon->finishLoading(budget);
+	bear->finishLoading(budget);
+
 	// Specify the values of the uniform variables we are going to use.
-	GLuint currentObjID = ((Model*)currentObj)->ID;
+	// Values that didn't change since the last frame aren't uploaded again.
+	ShaderProgram& currentObjProgram = ShaderProgram::get(((Model*)currentObj)->ID);
 	glm::mat4 currentObjModel = currentObj->getModel();
-	glUseProgram(currentObjID);
-	glUniformMatrix4fv(glGetUniformLocation(currentObjID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-	glUniformMatrix4fv(glGetUniformLocation(currentObjID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-	glUniformMatrix4fv(glGetUniformLocation(currentObjID, "model"), 1, GL_FALSE, glm::value_ptr(currentObjModel));
-	glUniform1i(glGetUniformLocation(currentObjID, "isLight"), 0);
+	currentObjProgram.use();
+	currentObjProgram.set("projection", projection);
+	currentObjProgram.set("view", view);
+	currentObjProgram.set("model", currentObjModel);
+	currentObjProgram.set("isLight", 0);
 
-	glUniform3fv(glGetUniformLocation(currentObjID, "viewPos"), 1, glm::value_ptr(eye));
+	currentObjProgram.set("viewPos", eye);
 
-	glUniform3fv(glGetUniformLocation(currentObjID, "light.position"), 1, glm::value_ptr(light->lightPos));
-	glUniform3f(glGetUniformLocation(currentObjID, "light.ambient"), 0.84725f, 0.795f, 0.0745f);
-	glUniform3f(glGetUniformLocation(currentObjID, "light.diffuse"), 0.75164f, 0.60648f, 0.22648f);
-	glUniform3f(glGetUniformLocation(currentObjID, "light.specular"), 0.628281f, 0.555802f, 0.366065f);
-	glUniform1f(glGetUniformLocation(currentObjID, "light.linear"), 0.09f);
+	currentObjProgram.set("light.position", light->lightPos);
+	currentObjProgram.set("light.ambient", glm::vec3(0.84725f, 0.795f, 0.0745f));
+	currentObjProgram.set("light.diffuse", glm::vec3(0.75164f, 0.60648f, 0.22648f));
+	currentObjProgram.set("light.specular", glm::vec3(0.628281f, 0.555802f, 0.366065f));
+	currentObjProgram.set("light.linear", 0.09f);
 
 	if (normalColoring) {
-		glUniform1i(glGetUniformLocation(currentObjID, "normalColoring"), 1);
+		currentObjProgram.set("normalColoring", 1);
 	}
 	else {
-		glUniform1i(glGetUniformLocation(currentObjID, "normalColoring"), 0);
+		currentObjProgram.set("normalColoring", 0);
 		if (((Model*)currentObj)->fileName.compare("bunny.obj") == 0)
 		{
-			glUniform3f(glGetUniformLocation(currentObjID, "material.ambient"), 0.8215f, 0.1745f, 0.0215f);
-			glUniform3f(glGetUniformLocation(currentObjID, "material.diffuse"), 0.0f, 0.0f, 0.0f);
-			glUniform3f(glGetUniformLocation(currentObjID, "material.specular"), 0.833f, 0.827811f, 0.833f);
-			glUniform1f(glGetUniformLocation(currentObjID, "material.shininess"), 128.0f);
+			currentObjProgram.set("material.ambient", glm::vec3(0.8215f, 0.1745f, 0.0215f));
+			currentObjProgram.set("material.diffuse", glm::vec3(0.0f, 0.0f, 0.0f));
+			currentObjProgram.set("material.specular", glm::vec3(0.833f, 0.827811f, 0.833f));
+			currentObjProgram.set("material.shininess", 128.0f);
 		}
 		else if (((Model*)currentObj)->fileName.compare("dragon.obj") == 0)
 		{
-			glUniform3f(glGetUniformLocation(currentObjID, "material.ambient"), 0.1745f, 0.8215f, 0.0215f);
-			glUniform3f(glGetUniformLocation(currentObjID, "material.diffuse"), 0.633f, 0.27811f, 0.533f);
-			glUniform3f(glGetUniformLocation(currentObjID, "material.specular"), 0.0f, 0.0f, 0.0f);
-			glUniform1f(glGetUniformLocation(currentObjID, "material.shininess"), 128.0f);
+			currentObjProgram.set("material.ambient", glm::vec3(0.1745f, 0.8215f, 0.0215f));
+			currentObjProgram.set("material.diffuse", glm::vec3(0.633f, 0.27811f, 0.533f));
+			currentObjProgram.set("material.specular", glm::vec3(0.0f, 0.0f, 0.0f));
+			currentObjProgram.set("material.shininess", 128.0f);
 		}
 		else if (((Model*)currentObj)->fileName.compare("bear.obj") == 0)
 		{
-			glUniform3f(glGetUniformLocation(currentObjID, "material.ambient"), 0.2f, 0.2f, 0.9f);
-			glUniform3f(glGetUniformLocation(currentObjID, "material.diffuse"), 0.2343f, 0.342f, 0.3733f);
-			glUniform3f(glGetUniformLocation(currentObjID, "material.specular"), 0.833f, 0.827811f, 0.833f);
-			glUniform1f(glGetUniformLocation(currentObjID, "material.shininess"), 128.0f);
+			currentObjProgram.set("material.ambient", glm::vec3(0.2f, 0.2f, 0.9f));
+			currentObjProgram.set("material.diffuse", glm::vec3(0.2343f, 0.342f, 0.3733f));
+			currentObjProgram.set("material.specular", glm::vec3(0.833f, 0.827811f, 0.833f));
+			currentObjProgram.set("material.shininess", 128.0f);
 		}
 	}
 
 	// Render the object.
 	currentObj->draw();
 
-	GLuint lightID = light->ID;
+	ShaderProgram& lightProgram = ShaderProgram::get(light->ID);
 	glm::mat4 lightModel = light->getModel();
-	glUseProgram(lightID);
-	glUniformMatrix4fv(glGetUniformLocation(lightID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-	glUniformMatrix4fv(glGetUniformLocation(lightID, "view"), 1, GL_FALSE, glm::value_ptr(view));
-	glUniformMatrix4fv(glGetUniformLocation(lightID, "model"), 1, GL_FALSE, glm::value_ptr(lightModel));
-	glUniform1i(glGetUniformLocation(lightID, "isLight"), 1);
-
-	glUniform3fv(glGetUniformLocation(lightID, "light.position"), 1, glm::value_ptr(light->lightPos));
-	glUniform3f(glGetUniformLocation(lightID, "light.ambient"), 0.84725f, 0.795f, 0.0745f);;
+	lightProgram.use();
+	lightProgram.set("projection", projection);
+	lightProgram.set("view", view);
+	lightProgram.set("model", lightModel);
+	lightProgram.set("isLight", 1);
+
+	lightProgram.set("light.position", light->lightPos);
+	lightProgram.set("light.ambient", glm::vec3(0.84725f, 0.795f, 0.0745f));
 
 	// Render the light object.
 	light->draw();
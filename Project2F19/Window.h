@@ -40,6 +40,8 @@ public:
 	static Model* dragon;
 	static Model* bear;
 	static Light* light;
+	static AsyncMeshLoader* loader;
+	static size_t uploadBudget;
 	static Object* currentObj;
 	static glm::vec3 curPoint;
 	static glm::vec3 lastPoint;
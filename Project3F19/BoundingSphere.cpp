@@ -2,125 +2,13 @@
 
 BoundingSphere::BoundingSphere(std::string filename)
 {
-    std::ifstream objFile(filename); // The obj file we are reading.
-    std::vector<glm::vec3> points;
-    std::vector<glm::vec3> normals;
-    std::vector<glm::ivec3> faceIndices;
+    // Normalized arrays, mapped from the binary cache when it is up to date.
+    // Faces share indices between points and normals.
+    MeshCache mesh;
+    mesh.load(filename, MESH_LAYOUT_SHARED_INDICES, 7.5f);
 
-    // Check whether the file can be opened.
-    if (objFile.is_open())
-    {
-        std::string line; // A line in the file.
-
-        // Read lines from the file.
-        while (std::getline(objFile, line))
-        {
-            // Turn the line into a string stream for processing.
-            std::stringstream ss;
-            ss << line;
-
-            // Read the first word of the line.
-            std::string label;
-            ss >> label;
-
-            // If the line is about vertex (starting with a "v").
-            if (label == "v")
-            {
-                // Read the later three float numbers and use them as the
-                // coordinates.
-                glm::vec3 point;
-                ss >> point.x >> point.y >> point.z;
-
-                // Process the point.
-                points.push_back(point);
-            }
-            else if (label == "vn") {
-                glm::vec3 normal;
-                ss >> normal.x >> normal.y >> normal.z;
-
-                normals.push_back(normal);
-            }
-            else if (label == "f") {
-                glm::ivec3 indices;
-                std::string v1IndexStr, v2IndexStr, v3IndexStr;
-                
-                ss >> v1IndexStr >> v2IndexStr >> v3IndexStr;
-                indices.x = atoi(v1IndexStr.c_str()) - 1;
-                indices.y = atoi(v2IndexStr.c_str()) - 1;
-                indices.z = atoi(v3IndexStr.c_str()) - 1;
-
-                faceIndices.push_back(indices);
-            }
-        }
-    }
-    else
-    {
-        std::cerr << "Can't open the file " << filename << std::endl;
-    }
-
-    objFile.close();
-
-    // Find center point of model
-    float minX = points[0].x, minY = points[0].y, minZ = points[0].z;
-    float maxX = points[0].x, maxY = points[0].y, maxZ = points[0].z;
-
-    for (std::vector<glm::vec3>::size_type i = 1; i < points.size(); i++)
-    {
-        if (points[i].x < minX)
-        {
-            minX = points[i].x;
-        }
-        if (points[i].y < minY)
-        {
-            minY = points[i].y;
-        }
-        if (points[i].z < minZ)
-        {
-            minZ = points[i].z;
-        }
-        if (points[i].x > maxX)
-        {
-            maxX = points[i].x;
-        }
-        if (points[i].y > maxY)
-        {
-            maxY = points[i].y;
-        }
-        if (points[i].z > maxZ)
-        {
-            maxZ = points[i].z;
-        }
-    }
-
-    // Find max distance away from center
-    float avgX = (maxX - minX) / 2, avgY = (maxY - minY) / 2, avgZ = (maxZ - minZ) / 2;
-    float maxDist;
-
-    if (avgX >= avgY && avgX >= avgZ)
-    {
-        maxDist = avgX;
-    }
-    else if (avgY >= avgX && avgY >= avgZ)
-    {
-        maxDist = avgY;
-    }
-    else if (avgZ >= avgX && avgZ >= avgY)
-    {
-        maxDist = avgZ;
-    }
-
-    // Normalizing scale
-    for (std::vector<glm::vec3>::size_type i = 0; i < points.size(); i++)
-    {
-        points[i].x -= (maxX + minX) / 2;
-        points[i].x *= 7.5f / maxDist;
-        points[i].y -= (maxY + minY) / 2;
-        points[i].y *= 7.5f / maxDist;
-        points[i].z -= (maxZ + minZ) / 2;
-        points[i].z *= 7.5f / maxDist;
-    }
-
-    indicesNum = faceIndices.size() * 3;
+    indicesNum = mesh.indexCount();
+    bounds = computeBounds(mesh.positions(), mesh.positionCount());
 
     // Model matrix.
     C = glm::mat4(1.0f);
@@ -133,21 +21,21 @@ BoundingSphere::BoundingSphere(std::string filename)
     glBindVertexArray(vao);
     
     glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(),
-        points.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.positionCount(),
+        mesh.positions(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
 
     glBindBuffer(GL_ARRAY_BUFFER, vbos[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * normals.size(),
-        normals.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.normalCount(),
+        mesh.normals(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
 
     glGenBuffers(1, &ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(glm::ivec3) * faceIndices.size(),
-        faceIndices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned) * mesh.indexCount(),
+        mesh.indices(), GL_STATIC_DRAW);
 
     // Unbind from the VBOs.
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -164,27 +52,38 @@ BoundingSphere::~BoundingSphere()
     glDeleteBuffers(1, &ebo);
     glDeleteVertexArrays(1, &vao);
     
-    glDeleteProgram(getShaderProgram());
+    ShaderProgram::release(getShaderProgram());
 }
 
-int BoundingSphere::draw(glm::mat4 C, std::vector<std::pair<glm::vec3, glm::vec3>> frustumPlanes)
+void BoundingSphere::draw(const glm::mat4& C, DrawContext& context, int lod)
 {
     this->C = C;
     
-    glUseProgram(getShaderProgram());
-    glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "model"), 1, GL_FALSE, glm::value_ptr(this->C));
-    
-    // Bind to the VAO.
-    glBindVertexArray(vao);
-    // Draw triangles using the indices in the second VBO, which is an
-    // element array buffer.
-    glDrawElements(GL_TRIANGLES, indicesNum, GL_UNSIGNED_INT, 0);
-    // Unbind from the VAO.
-    glBindVertexArray(0);
-    
-    return 0;
+    // Draw triangles using the indices in the element array buffer, once
+    // the frame's draws are sorted.
+    DrawPacket packet;
+    packet.program = getShaderProgram();
+    packet.vao = vao;
+    packet.mode = GL_TRIANGLES;
+    packet.count = indicesNum;
+    packet.indexOffset = 0;
+    packet.instanceCount = 0;
+    packet.model = C;
+    packet.depth = context.queue->depth(glm::vec3(C[3]));
+    packet.bindMaterial = bindMaterial;
+    packet.material = this;
+    context.queue->push(packet);
+}
+
+void BoundingSphere::bindMaterial(ShaderProgram& program, const void* material)
+{
+    // The program is shared with Geometry, which may have left it decoding
+    // quantized vertices or reading instanced model matrices.
+    program.set("quantized", 0);
+    program.set("instanced", 0);
 }
 
-void BoundingSphere::update()
+Bounds BoundingSphere::getBounds()
 {
+    return bounds;
 }
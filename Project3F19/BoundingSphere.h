@@ -9,6 +9,8 @@
 #endif
 
 #include "Node.h"
+#include "../Common/MeshCache.h"
+#include "../Common/RenderQueue.h"
 
 class BoundingSphere : public Node
 {
@@ -18,11 +20,14 @@ private:
     GLuint vbos[2];
     GLuint ebo;
     int indicesNum;
+    Bounds bounds;
+    
+    static void bindMaterial(ShaderProgram& program, const void* material);
 public:
     BoundingSphere(std::string filename);
     ~BoundingSphere();
-    int draw(glm::mat4 C, std::vector<std::pair<glm::vec3, glm::vec3>> frustumPlanes);
-    void update();
+    void draw(const glm::mat4& C, DrawContext& context, int lod);
+    Bounds getBounds();
 };
 
 #endif
@@ -0,0 +1,43 @@
+#ifndef _DRAW_CONTEXT_H_
+#define _DRAW_CONTEXT_H_
+
+#include <glm/glm.hpp>
+
+#include "../Common/RenderQueue.h"
+
+class OcclusionCuller;
+class SkinnedMesh;
+
+// Everything one traversal of the scene graph needs, filled in once per
+// frame and passed down by reference so nodes don't copy or allocate.
+struct DrawContext
+{
+    // Frustum planes as (outward normal, offset); a point p is outside a
+    // plane by dot(normal, p) + offset.
+    glm::vec4 frustumPlanes[6];
+    // Projection * view the planes come from.
+    glm::mat4 viewProjection;
+    glm::vec3 eye;
+    // Pixels per unit at distance 1, for picking levels of detail.
+    float lodScale;
+    // Seconds of animation. The recursive traversal sets timeOffset for
+    // each robot it reaches, counting them in robotsReached.
+    double time;
+    float timeOffset;
+    int robotsReached;
+    RenderQueue* queue;
+    // Tests the frustum culled robots against last frame's depth; null to
+    // skip.
+    OcclusionCuller* occlusion;
+    // Draws each copy of its root's subtree as one skinned instance instead
+    // of part by part; null to skip.
+    SkinnedMesh* skin;
+    // Counted during the traversal.
+    int visibleRobots;
+    int culledRobots;
+    int occludedRobots;
+    // World matrices computed this frame, by the traversal or beforehand.
+    int recomputedMatrices;
+};
+
+#endif
@@ -1,166 +1,23 @@
 #include "Geometry.h"
-// bounding sphere radius = 2.313938
-Geometry::Geometry(std::string filename)
-{
-    std::ifstream objFile(filename); // The obj file we are reading.
-    std::vector<glm::vec3> inputVertices;
-    std::vector<glm::vec3> inputNormals;
-    std::vector<int> vertexIndices;
-    std::vector<int> normalIndices;
-    
-    // Check whether the file can be opened.
-    if (objFile.is_open())
-    {
-        std::string line; // A line in the file.
-        
-        // Read lines from the file.
-        while (std::getline(objFile, line))
-        {
-            // Turn the line into a string stream for processing.
-            std::stringstream ss;
-            ss << line;
-            
-            // Read the first word of the line.
-            std::string label;
-            ss >> label;
-            
-            // If the line is about vertex (starting with a "v").
-            if (label == "v")
-            {
-                // Read the later three float numbers and use them as the
-                // coordinates.
-                glm::vec3 point;
-                ss >> point.x >> point.y >> point.z;
-                
-                // Process the point.
-                inputVertices.push_back(point);
-            }
-            else if (label == "vn")
-            {
-                glm::vec3 normal;
-                ss >> normal.x >> normal.y >> normal.z;
-                
-                inputNormals.push_back(normal);
-            }
-            else if (label == "f")
-            {
-                std::string vertex1, vertex2, vertex3;
-                int v, vt, vn;
-                char slash;
-                
-                ss >> vertex1 >> vertex2 >> vertex3;
 
-                std::stringstream first;
-                first << vertex1;
-                first >> v >> slash >> vt >> slash >> vn;
-                v--;
-                vt--;
-                vn--;
-                
-                vertexIndices.push_back(v);
-                normalIndices.push_back(vn);
-                
-                std::stringstream second;
-                second << vertex2;
-                second >> v >> slash >> vt >> slash >> vn;
-                v--;
-                vt--;
-                vn--;
-                
-                vertexIndices.push_back(v);
-                normalIndices.push_back(vn);
-                
-                std::stringstream third;
-                third << vertex3;
-                third >> v >> slash >> vt >> slash >> vn;
-                v--;
-                vt--;
-                vn--;
-                
-                vertexIndices.push_back(v);
-                normalIndices.push_back(vn);
-            }
-        }
-    }
-    else
-    {
-        std::cerr << "Can't open the file " << filename << std::endl;
-    }
-    
-    objFile.close();
-    
-    std::vector<glm::vec3> vertices;
-    std::vector<glm::vec3> normals;
-    std::vector<int> indices;
-    
-    for (unsigned i = 0; i < vertexIndices.size(); i++)
-    {
-      vertices.push_back(inputVertices[vertexIndices[i]]);
-      normals.push_back(inputNormals[normalIndices[i]]);
-      indices.push_back(i);
-    }
-    
-    // Find center point of model
-    float minX = vertices[0].x, minY = vertices[0].y, minZ = vertices[0].z;
-    float maxX = vertices[0].x, maxY = vertices[0].y, maxZ = vertices[0].z;
-    
-    for (std::vector<glm::vec3>::size_type i = 1; i < vertices.size(); i++)
-    {
-        if (vertices[i].x < minX)
-        {
-            minX = vertices[i].x;
-        }
-        if (vertices[i].y < minY)
-        {
-            minY = vertices[i].y;
-        }
-        if (vertices[i].z < minZ)
-        {
-            minZ = vertices[i].z;
-        }
-        if (vertices[i].x > maxX)
-        {
-            maxX = vertices[i].x;
-        }
-        if (vertices[i].y > maxY)
-        {
-            maxY = vertices[i].y;
-        }
-        if (vertices[i].z > maxZ)
-        {
-            maxZ = vertices[i].z;
-        }
-    }
-    
-    // Find max distance away from center
-    float avgX = (maxX - minX) / 2, avgY = (maxY - minY) / 2, avgZ = (maxZ - minZ) / 2;
-    float maxDist = 0;
-    
-    if (avgX >= avgY && avgX >= avgZ)
-    {
-        maxDist = avgX;
-    }
-    else if (avgY >= avgX && avgY >= avgZ)
-    {
-        maxDist = avgY;
-    }
-    else if (avgZ >= avgX && avgZ >= avgY)
-    {
-        maxDist = avgZ;
-    }
-    
-    // Normalizing scale
-    for (std::vector<glm::vec3>::size_type i = 0; i < vertices.size(); i++)
+bool Geometry::instancingOn = true;
+std::vector<Geometry*> Geometry::pending;
+Geometry::Geometry(std::string filename, VertexFormat format)
+    : filename(filename), batched(false)
+{
+    // Normalized arrays with one vertex per distinct point/normal pair,
+    // reordered for the vertex cache and simplified into levels of detail,
+    // mapped from the binary cache when it is up to date.
+    MeshCache mesh;
+    mesh.load(filename, MESH_LAYOUT_WELDED, 7.5f, true, maxMeshLods);
+    
+    lodCount = (int)mesh.lodCount();
+    for (int i = 0; i < lodCount; i++)
     {
-        vertices[i].x -= (maxX + minX) / 2;
-        vertices[i].x *= 7.5f / maxDist;
-        vertices[i].y -= (maxY + minY) / 2;
-        vertices[i].y *= 7.5f / maxDist;
-        vertices[i].z -= (maxZ + minZ) / 2;
-        vertices[i].z *= 7.5f / maxDist;
+        lods[i] = mesh.lod(i);
     }
-    
-    indicesNum = vertexIndices.size();
+    indicesNum = lods[0].indexCount;
+    bounds = computeBounds(mesh.positions(), mesh.positionCount());
     
     // Model matrix.
     C = glm::mat4(1.0f);
@@ -172,28 +29,46 @@ Geometry::Geometry(std::string filename)
     // Bind to the VAO.
     glBindVertexArray(vao);
     
-    glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * vertices.size(),
-                 vertices.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, vbos[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * normals.size(),
-                 normals.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
+    packVertices(mesh, format, vertices);
+    if (format == VERTEX_FORMAT_SEPARATE)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.positionCount(),
+                     mesh.positions(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[1]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.normalCount(),
+                     mesh.normals(), GL_STATIC_DRAW);
+    }
+    else
+    {
+        // Position and normal interleaved in the first VBO.
+        glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
+        glBufferData(GL_ARRAY_BUFFER, vertices.data.size(), vertices.data.data(), GL_STATIC_DRAW);
+        std::vector<unsigned char>().swap(vertices.data);
+    }
+    setVertexAttributes(format, vbos[0], vbos[1]);
     
     glGenBuffers(1, &ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(int), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexCount() * sizeof(unsigned), mesh.indices(), GL_STATIC_DRAW);
+    
+    // Per instance model matrix in attributes 2 to 5, one column each.
+    glGenBuffers(1, &instanceVbo);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+    for (int i = 0; i < 4; i++)
+    {
+        glEnableVertexAttribArray(2 + i);
+        glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(2 + i, 1);
+    }
     
     // Unbind from the VBOs.
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     // Unbind from the VAO.
     glBindVertexArray(0);
     
-    printf("Finished %s\n", filename.c_str());
+    printf("Finished %s: %zu vertices for %d indices (%.2fx fewer than unwelded)\n", filename.c_str(),
+           mesh.positionCount(), indicesNum, mesh.positionCount() ? (float)indicesNum / mesh.positionCount() : 0.0f);
 }
 
 Geometry::~Geometry()
@@ -201,29 +76,121 @@ Geometry::~Geometry()
     // Delete the VBOs, EBO, and VAO.
     glDeleteBuffers(2, vbos);
     glDeleteBuffers(1, &ebo);
+    glDeleteBuffers(1, &instanceVbo);
     glDeleteVertexArrays(1, &vao);
     
-    glDeleteProgram(getShaderProgram());
+    ShaderProgram::release(getShaderProgram());
 }
 
-int Geometry::draw(glm::mat4 C, std::vector<std::pair<glm::vec3, glm::vec3>> frustumPlanes)
+void Geometry::draw(const glm::mat4& C, DrawContext& context, int lod)
 {
     this->C = C;
+    lod = lod < lodCount ? lod : lodCount - 1;
     
-    glUseProgram(getShaderProgram());
-    glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "model"), 1, GL_FALSE, glm::value_ptr(this->C));
-    
-    // Bind to the VAO.
-    glBindVertexArray(vao);
-    // Draw triangles using the indices in the second VBO, which is an
-    // element array buffer.
-    glDrawElements(GL_TRIANGLES, indicesNum, GL_UNSIGNED_INT, 0);
-    // Unbind from the VAO.
-    glBindVertexArray(0);
+    if (instancingOn)
+    {
+        // Queued later by queueInstances, together with every other copy.
+        if (!batched)
+        {
+            pending.push_back(this);
+            batched = true;
+        }
+        instances[lod].push_back(C);
+        return;
+    }
     
-    return 0;
+    // Draw triangles using the indices of the chosen level of detail in the
+    // element array buffer, once the frame's draws are sorted.
+    const MeshLod& level = lods[lod];
+    DrawPacket packet;
+    packet.program = getShaderProgram();
+    packet.vao = vao;
+    packet.mode = GL_TRIANGLES;
+    packet.count = level.indexCount;
+    packet.indexOffset = level.indexOffset * sizeof(unsigned);
+    packet.instanceCount = 0;
+    packet.model = C;
+    packet.depth = context.queue->depth(glm::vec3(C[3]));
+    packet.bindMaterial = bindMaterial;
+    packet.material = this;
+    context.queue->push(packet);
+}
+
+void Geometry::bindMaterial(ShaderProgram& program, const void* material)
+{
+    const Geometry* geometry = (const Geometry*)material;
+    program.set("instanced", 0);
+    setVertexDecodeUniforms(program, geometry->vertices);
+}
+
+void Geometry::bindInstances(ShaderProgram& program, const void* material)
+{
+    const InstanceRange* range = (const InstanceRange*)material;
+    program.set("instanced", 1);
+    setVertexDecodeUniforms(program, range->geometry->vertices);
+    
+    // Point the instance attributes of the bound VAO at this level's
+    // matrices.
+    glBindBuffer(GL_ARRAY_BUFFER, range->geometry->instanceVbo);
+    for (int column = 0; column < 4; column++)
+    {
+        glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(range->first * sizeof(glm::mat4) + column * sizeof(glm::vec4)));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Bounds Geometry::getBounds()
+{
+    return bounds;
 }
 
-void Geometry::update()
+void Geometry::queueInstances(RenderQueue& queue)
 {
+    for (Geometry* geometry : pending)
+    {
+        size_t total = 0;
+        for (int i = 0; i < geometry->lodCount; i++)
+        {
+            total += geometry->instances[i].size();
+        }
+        
+        // Orphan the buffer and write each level's matrices after the last.
+        glBindBuffer(GL_ARRAY_BUFFER, geometry->instanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, total * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+        size_t first = 0;
+        for (int i = 0; i < geometry->lodCount; i++)
+        {
+            std::vector<glm::mat4>& instances = geometry->instances[i];
+            if (instances.empty())
+            {
+                continue;
+            }
+            glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(glm::mat4), instances.size() * sizeof(glm::mat4), instances.data());
+            
+            geometry->ranges[i].geometry = geometry;
+            geometry->ranges[i].first = first;
+            
+            const MeshLod& level = geometry->lods[i];
+            DrawPacket packet;
+            packet.program = geometry->getShaderProgram();
+            packet.vao = geometry->vao;
+            packet.mode = GL_TRIANGLES;
+            packet.count = level.indexCount;
+            packet.indexOffset = level.indexOffset * sizeof(unsigned);
+            packet.instanceCount = (GLsizei)instances.size();
+            packet.model = glm::mat4(1.0f);
+            packet.depth = 0.0f;
+            packet.bindMaterial = bindInstances;
+            packet.material = &geometry->ranges[i];
+            queue.push(packet);
+            
+            first += instances.size();
+            instances.clear();
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        
+        geometry->batched = false;
+    }
+    pending.clear();
 }
@@ -9,20 +9,54 @@
 #endif
 
 #include "Node.h"
+#include "../Common/MeshCache.h"
+#include "../Common/VertexFormat.h"
+#include "../Common/RenderQueue.h"
 
 class Geometry : public Node
 {
 private:
+    std::string filename;
     glm::mat4 C;
     GLuint vao;
     GLuint vbos[2];
     GLuint ebo;
     int indicesNum;
+    // Index ranges of the levels of detail, all in ebo.
+    MeshLod lods[maxMeshLods];
+    int lodCount;
+    // Decode parameters for the vertex shader; only the scale and offset
+    // are kept once the vertices are uploaded.
+    PackedVertices vertices;
+    Bounds bounds;
+    // Model matrices collected for each level of detail while instancing,
+    // streamed into instanceVbo by queueInstances.
+    std::vector<glm::mat4> instances[maxMeshLods];
+    GLuint instanceVbo;
+    bool batched;
+    static std::vector<Geometry*> pending;
+    
+    // Where each level's matrices start in instanceVbo this frame.
+    struct InstanceRange
+    {
+        const Geometry* geometry;
+        size_t first;
+    };
+    InstanceRange ranges[maxMeshLods];
+    
+    static void bindMaterial(ShaderProgram& program, const void* material);
+    static void bindInstances(ShaderProgram& program, const void* material);
 public:
-    Geometry(std::string filename);
+    Geometry(std::string filename, VertexFormat format = VERTEX_FORMAT_QUANTIZED);
     ~Geometry();
-    int draw(glm::mat4 C, std::vector<std::pair<glm::vec3, glm::vec3>> frustumPlanes);
-    void update();
+    void draw(const glm::mat4& C, DrawContext& context, int lod);
+    Bounds getBounds();
+    // The OBJ the geometry was loaded from.
+    const std::string& getFilename() const { return filename; }
+    // Uploads every instance collected since the last call and queues one
+    // instanced draw per geometry and level of detail.
+    static void queueInstances(RenderQueue& queue);
+    static bool instancingOn;
 };
 
 #endif
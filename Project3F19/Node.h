@@ -16,14 +16,23 @@
 #include <fstream>
 
 #include "shader.h"
+#include "../Common/ShaderProgram.h"
+#include "../Common/Bounds.h"
+#include "DrawContext.h"
 
 class Node
 {
 private:
     GLuint shaderProgram;
 public:
-    virtual int draw(glm::mat4 C, std::vector<std::pair<glm::vec3, glm::vec3>> frustumPlanes) = 0;
-    virtual void update() = 0;
+    // lod is the level of detail chosen for the subtree, 0 being the most
+    // detailed.
+    virtual void draw(const glm::mat4& C, DrawContext& context, int lod) = 0;
+    // Bounds of everything the node draws, in the space its parent draws
+    // it in.
+    virtual Bounds getBounds() {
+        return emptyBounds();
+    }
     GLuint getShaderProgram() {
         return shaderProgram;
     }
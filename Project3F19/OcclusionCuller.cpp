@@ -0,0 +1,277 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+// How far, relative to its size, any element of projection * view may move
+// before results tested under the old one are dropped; about half a degree
+// of turning.
+static const float staleTolerance = 0.01f;
+
+static bool viewMoved(const glm::mat4& a, const glm::mat4& b)
+{
+    for (int column = 0; column < 4; column++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            float x = a[column][row];
+            float y = b[column][row];
+            if (std::fabs(x - y) > staleTolerance * std::max(std::max(std::fabs(x), std::fabs(y)), 1.0f))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+OcclusionCuller::OcclusionCuller()
+    : depthTexture(0), width(0), height(0), levels(0), windowWidth(0), windowHeight(0), frame(0), resultCount(0),
+      resultFrame(0), ready(false)
+{
+    pyramidProgram = LoadShaders("shaders/depthPyramid.vert", "shaders/depthPyramid.frag");
+    testProgram = LoadFeedbackShader("shaders/occlusion.vert", "visible");
+    ShaderProgram::get(pyramidProgram).set("depth", 0);
+    ShaderProgram::get(testProgram).set("depthPyramid", 0);
+    
+    glGenFramebuffers(1, &framebuffer);
+    glGenVertexArrays(1, &emptyVao);
+    
+    for (Query& query: queries)
+    {
+        glGenVertexArrays(1, &query.vao);
+        glGenBuffers(1, &query.sphereBuffer);
+        glGenBuffers(1, &query.resultBuffer);
+        glBindVertexArray(query.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, query.sphereBuffer);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+        query.capacity = 0;
+        query.count = 0;
+        query.fence = nullptr;
+        query.frame = 0;
+    }
+}
+
+OcclusionCuller::~OcclusionCuller()
+{
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &depthTexture);
+    glDeleteVertexArrays(1, &emptyVao);
+    for (Query& query: queries)
+    {
+        if (query.fence)
+        {
+            glDeleteSync(query.fence);
+        }
+        glDeleteVertexArrays(1, &query.vao);
+        glDeleteBuffers(1, &query.sphereBuffer);
+        glDeleteBuffers(1, &query.resultBuffer);
+    }
+    ShaderProgram::release(pyramidProgram);
+    ShaderProgram::release(testProgram);
+}
+
+void OcclusionCuller::resize(int windowWidth, int windowHeight)
+{
+    this->windowWidth = windowWidth;
+    this->windowHeight = windowHeight;
+    width = std::max(windowWidth / 2, 1);
+    height = std::max(windowHeight / 2, 1);
+    levels = 1;
+    while ((std::max(width, height) >> levels) > 0)
+    {
+        levels++;
+    }
+    
+    // Every level down to 1x1, read with texelFetch only.
+    glDeleteTextures(1, &depthTexture);
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    for (int level = 0; level < levels; level++)
+    {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_DEPTH_COMPONENT32F, std::max(width >> level, 1),
+                     std::max(height >> level, 1), 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    // Depth only.
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    
+    ShaderProgram::get(testProgram).set("levels", levels);
+    ready = false;
+    resultCount = 0;
+}
+
+void OcclusionCuller::beginDepth(const glm::mat4& viewProjection)
+{
+    pyramidViewProjection = viewProjection;
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    glViewport(0, 0, width, height);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void OcclusionCuller::endDepth()
+{
+    buildPyramid();
+    
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, windowWidth, windowHeight);
+    ready = true;
+}
+
+void OcclusionCuller::buildPyramid()
+{
+    ShaderProgram::get(pyramidProgram).use();
+    glBindVertexArray(emptyVao);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    // Every fragment writes its depth.
+    glDepthFunc(GL_ALWAYS);
+    
+    for (int level = 1; level < levels; level++)
+    {
+        // Read only the level below while writing this one.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, level);
+        glViewport(0, 0, std::max(width >> level, 1), std::max(height >> level, 1));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glDepthFunc(GL_LEQUAL);
+}
+
+unsigned OcclusionCuller::test(const glm::mat4& viewProjection, const SphereSet& spheres,
+                               const std::vector<uint32_t>& visible, std::vector<uint32_t>& occluded)
+{
+    size_t count = spheres.size();
+    occluded.assign((count + 31) / 32, 0);
+    
+    // Whichever tests have finished, newest last, without waiting.
+    for (Query& query: queries)
+    {
+        collect(query);
+    }
+    
+    // Into a set of buffers the GPU is done with; if both are still busy the
+    // GPU is behind, and this frame goes untested rather than waiting.
+    frame++;
+    if (ready && count > 0)
+    {
+        for (Query& query: queries)
+        {
+            if (!query.fence)
+            {
+                issue(query, spheres, viewProjection);
+                break;
+            }
+        }
+    }
+    
+    if (resultCount != count || viewMoved(resultViewProjection, viewProjection))
+    {
+        return 0;
+    }
+    unsigned hidden = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!results[i] && isVisible(visible, i))
+        {
+            occluded[i >> 5] |= 1u << (i & 31);
+            hidden++;
+        }
+    }
+    return hidden;
+}
+
+void OcclusionCuller::issue(Query& query, const SphereSet& spheres, const glm::mat4& viewProjection)
+{
+    size_t count = spheres.size();
+    sphereData.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        sphereData[i] = glm::vec4(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]);
+    }
+    
+    // Grow the buffers to fit, never shrink them.
+    glBindBuffer(GL_ARRAY_BUFFER, query.sphereBuffer);
+    if (count > query.capacity)
+    {
+        query.capacity = count;
+        glBufferData(GL_ARRAY_BUFFER, query.capacity * sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, query.resultBuffer);
+        glBufferData(GL_TRANSFORM_FEEDBACK_BUFFER, query.capacity * sizeof(uint32_t), NULL, GL_STREAM_READ);
+        glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(glm::vec4), sphereData.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    
+    ShaderProgram& program = ShaderProgram::get(testProgram);
+    program.use();
+    program.set("viewProjection", pyramidViewProjection);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glBindVertexArray(query.vao);
+    
+    // Nothing is drawn, only the varying is kept.
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, query.resultBuffer);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, (GLsizei)count);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glDisable(GL_RASTERIZER_DISCARD);
+    
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    
+    query.count = count;
+    query.frame = frame;
+    query.viewProjection = viewProjection;
+    query.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void OcclusionCuller::collect(Query& query)
+{
+    if (!query.fence)
+    {
+        return;
+    }
+    // Flushed so a fence from the last frame is sure to get there.
+    GLenum status = glClientWaitSync(query.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+    {
+        return;
+    }
+    glDeleteSync(query.fence);
+    query.fence = nullptr;
+    
+    // An older test finishing after a newer one was read is of no use.
+    if (resultCount > 0 && query.frame < resultFrame)
+    {
+        return;
+    }
+    results.resize(query.count);
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, query.resultBuffer);
+    glGetBufferSubData(GL_TRANSFORM_FEEDBACK_BUFFER, 0, query.count * sizeof(uint32_t), results.data());
+    glBindBuffer(GL_TRANSFORM_FEEDBACK_BUFFER, 0);
+    resultCount = query.count;
+    resultFrame = query.frame;
+    resultViewProjection = query.viewProjection;
+}
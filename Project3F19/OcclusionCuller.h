@@ -0,0 +1,98 @@
+#ifndef _OCCLUSION_CULLER_H_
+#define _OCCLUSION_CULLER_H_
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "shader.h"
+#include "../Common/ShaderProgram.h"
+#include "../Common/SphereCuller.h"
+
+// Culls bounding spheres hidden behind what was drawn last frame. The frame's
+// visible draws are drawn again into a half resolution depth texture, which
+// is reduced into a pyramid whose texels keep the farthest depth under them
+// (Hi-Z). Next frame each sphere's screen rectangle is compared against the
+// pyramid level where it covers at most 2x2 texels, in a vertex shader whose
+// results come back through transform feedback.
+//
+// Results are read back a frame later, once a fence says the GPU is done
+// with them, so the CPU never waits on the test. Until they arrive nothing
+// is culled. They are dropped once the camera has moved on from where it
+// was when the test was issued, since what they hide may be in view by
+// then; while it holds still, a robot coming out from behind something
+// stays hidden for the frame or two its results take.
+//
+// Only OpenGL 3.3 is needed, no compute shaders.
+class OcclusionCuller
+{
+private:
+    GLuint framebuffer;
+    GLuint depthTexture;
+    int width;
+    int height;
+    int levels;
+    int windowWidth;
+    int windowHeight;
+    
+    GLuint pyramidProgram;
+    GLuint testProgram;
+    // Attribute-less VAO for the full screen triangle.
+    GLuint emptyVao;
+    
+    // Two sets of buffers, so one frame's test can be in flight while the
+    // one before it is read.
+    struct Query
+    {
+        GLuint vao;
+        GLuint sphereBuffer;
+        GLuint resultBuffer;
+        size_t capacity;
+        size_t count;
+        // Set once the test is issued, cleared once its results are read.
+        GLsync fence;
+        unsigned frame;
+        // Projection * view of the frame the test was issued in.
+        glm::mat4 viewProjection;
+    };
+    Query queries[2];
+    unsigned frame;
+    std::vector<glm::vec4> sphereData;
+    // The newest results read back, for resultCount spheres.
+    std::vector<uint32_t> results;
+    size_t resultCount;
+    unsigned resultFrame;
+    glm::mat4 resultViewProjection;
+    
+    // Projection * view the pyramid was drawn with; false until one is.
+    glm::mat4 pyramidViewProjection;
+    bool ready;
+    
+    void buildPyramid();
+    void issue(Query& query, const SphereSet& spheres, const glm::mat4& viewProjection);
+    void collect(Query& query);
+public:
+    OcclusionCuller();
+    ~OcclusionCuller();
+    void resize(int windowWidth, int windowHeight);
+    // Draw the occluders between these, with viewProjection being what the
+    // draws use.
+    void beginDepth(const glm::mat4& viewProjection);
+    void endDepth();
+    // Tests the spheres against the last pyramid, then sets the bits in
+    // occluded of the visible spheres that the newest finished test found
+    // hidden, and returns how many were. That test is of an earlier frame,
+    // so its results are only used while the spheres are the same ones and
+    // viewProjection, this frame's, is still close to the one it had.
+    unsigned test(const glm::mat4& viewProjection, const SphereSet& spheres, const std::vector<uint32_t>& visible,
+                  std::vector<uint32_t>& occluded);
+};
+
+#endif
@@ -0,0 +1,285 @@
+#include "Scene.h"
+
+static const glm::mat4 identity(1.0f);
+
+bool Scene::bvhOn = true;
+
+void Scene::build(Transform* root)
+{
+    for (Transform* transform: source)
+    {
+        transform->scene = nullptr;
+        transform->entries.clear();
+    }
+    
+    local.clear();
+    world.clear();
+    parent.clear();
+    subtreeEnd.clear();
+    source.clear();
+    dirty.clear();
+    isDirty.clear();
+    firstLeaf.clear();
+    leaves.clear();
+    lods.clear();
+    timeOffset.clear();
+    animationRoots.clear();
+    animatedEntries = 0;
+    cullable.clear();
+    sphereIndex.clear();
+    spheres.clear();
+    spheresMoved = true;
+    
+    add(root, -1);
+    firstLeaf.push_back((int)leaves.size());
+    lods.assign(local.size(), 0);
+    
+    int coveredEnd = 0;
+    for (int i = 0; i < (int)source.size(); i++)
+    {
+        if (i >= coveredEnd && source[i]->isAnimated())
+        {
+            animationRoots.push_back(i);
+            coveredEnd = subtreeEnd[i];
+            animatedEntries += coveredEnd - i;
+        }
+    }
+    update();
+}
+
+int Scene::add(Transform* transform, int parentIndex)
+{
+    int index = (int)local.size();
+    local.push_back(transform->getMatrix());
+    world.push_back(glm::mat4(1.0f));
+    parent.push_back(parentIndex);
+    subtreeEnd.push_back(index + 1);
+    source.push_back(transform);
+    sphereIndex.push_back(-1);
+    timeOffset.push_back(parentIndex >= 0 ? timeOffset[parentIndex] : 0.0f);
+    if (transform->isCullable())
+    {
+        timeOffset[index] = Transform::timeOffset((int)cullable.size());
+        sphereIndex[index] = (int)cullable.size();
+        cullable.push_back(index);
+    }
+    transform->scene = this;
+    transform->entries.push_back(index);
+    
+    // Everything starts out dirty; marking the root alone is enough since
+    // its subtree is the whole scene.
+    isDirty.push_back(parentIndex < 0);
+    if (parentIndex < 0)
+    {
+        dirty.push_back(index);
+    }
+    
+    // Leaves first so each entry's are contiguous, then the child
+    // Transforms depth first.
+    firstLeaf.push_back((int)leaves.size());
+    const std::vector<Node*>& children = transform->getChildren();
+    for (Node* child: children)
+    {
+        if (!dynamic_cast<Transform*>(child))
+        {
+            leaves.push_back(child);
+        }
+    }
+    for (Node* child: children)
+    {
+        Transform* childTransform = dynamic_cast<Transform*>(child);
+        if (childTransform)
+        {
+            add(childTransform, index);
+        }
+    }
+    subtreeEnd[index] = (int)local.size();
+    return index;
+}
+
+void Scene::markDirty(const std::vector<int>& entries)
+{
+    for (int entry: entries)
+    {
+        if (!isDirty[entry])
+        {
+            isDirty[entry] = 1;
+            dirty.push_back(entry);
+        }
+    }
+}
+
+unsigned Scene::update(double time, JobSystem* jobs)
+{
+    unsigned recomputed = 0;
+    for (int entry: dirty)
+    {
+        local[entry] = source[entry]->getMatrix();
+        isDirty[entry] = 0;
+    }
+    
+    // In index order a dirty ancestor comes before its dirty descendants,
+    // whose subtrees are then already covered by its own.
+    std::sort(dirty.begin(), dirty.end());
+    int coveredEnd = 0;
+    for (int entry: dirty)
+    {
+        if (entry < coveredEnd)
+        {
+            continue;
+        }
+        
+        // Parents come first, so each entry's parent is final by the time
+        // it is reached.
+        coveredEnd = subtreeEnd[entry];
+        for (int i = entry; i < coveredEnd; i++)
+        {
+            int p = parent[i];
+            world[i] = p >= 0 ? world[p] * local[i] : local[i];
+        }
+        recomputed += coveredEnd - entry;
+        
+        // A cullable entry's sphere is its bounds under its parent's world
+        // matrix, and its own M is part of those bounds, so it moved if it
+        // is anywhere in the range, the start included.
+        std::vector<int>::const_iterator moved = std::lower_bound(cullable.begin(), cullable.end(), entry);
+        if (moved != cullable.end() && *moved < coveredEnd)
+        {
+            spheresMoved = true;
+        }
+    }
+    dirty.clear();
+    
+    // Animated subtrees sit below everything recomputed above and don't
+    // overlap, so each can be posed on its own thread.
+    auto animate = [&](size_t first, size_t last)
+    {
+        for (size_t root = first; root < last; root++)
+        {
+            int entry = animationRoots[root];
+            for (int i = entry; i < subtreeEnd[entry]; i++)
+            {
+                if (source[i]->isAnimated())
+                {
+                    local[i] = source[i]->pose(time + timeOffset[i]);
+                }
+                int p = parent[i];
+                world[i] = p >= 0 ? world[p] * local[i] : local[i];
+            }
+        }
+    };
+    if (jobs)
+    {
+        jobs->parallelFor(animationRoots.size(), 256, animate);
+    }
+    else
+    {
+        animate(0, animationRoots.size());
+    }
+    recomputed += animatedEntries;
+    
+    if (spheresMoved)
+    {
+        gatherSpheres(jobs);
+        spheresMoved = false;
+    }
+    return recomputed;
+}
+
+void Scene::gatherSpheres(JobSystem* jobs)
+{
+    spheres.x.resize(cullable.size());
+    spheres.y.resize(cullable.size());
+    spheres.z.resize(cullable.size());
+    spheres.radius.resize(cullable.size());
+    auto gather = [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; i++)
+        {
+            int entry = cullable[i];
+            int p = parent[entry];
+            Bounds bounds = transformBounds(source[entry]->getBounds(), p >= 0 ? world[p] : identity);
+            spheres.x[i] = bounds.center.x;
+            spheres.y[i] = bounds.center.y;
+            spheres.z[i] = bounds.center.z;
+            spheres.radius[i] = bounds.radius;
+        }
+    };
+    if (jobs)
+    {
+        jobs->parallelFor(cullable.size(), 1024, gather);
+    }
+    else
+    {
+        gather(0, cullable.size());
+    }
+    bvh.refit(spheres);
+}
+
+void Scene::draw(DrawContext& context)
+{
+    // Every robot's sphere against the frustum in one pass, either through
+    // the hierarchy or 4 or 8 at a time.
+    bool culling = Transform::cullingOn;
+    if (culling)
+    {
+        if (bvhOn)
+        {
+            bvh.cull(context.frustumPlanes, spheres, sphereVisible);
+        }
+        else
+        {
+            cullSpheres(context.frustumPlanes, spheres, sphereVisible);
+        }
+    }
+    bool occlusion = culling && context.occlusion;
+    if (occlusion)
+    {
+        context.occlusion->test(context.viewProjection, spheres, sphereVisible, sphereOccluded);
+    }
+    
+    SkinnedMesh* skin = context.skin;
+    int count = (int)local.size();
+    int i = 0;
+    while (i < count)
+    {
+        // Each entry starts from its parent's level of detail and is handed
+        // its parent's world matrix, as in the recursive traversal.
+        int p = parent[i];
+        int lod = p >= 0 ? lods[p] : 0;
+        bool tested = culling && sphereIndex[i] >= 0;
+        if (tested && !isVisible(sphereVisible, sphereIndex[i]))
+        {
+            context.culledRobots++;
+            i = subtreeEnd[i];
+            continue;
+        }
+        if (tested && occlusion && isVisible(sphereOccluded, sphereIndex[i]))
+        {
+            context.occludedRobots++;
+            i = subtreeEnd[i];
+            continue;
+        }
+        if (!source[i]->visible(p >= 0 ? world[p] : identity, context, lod, tested))
+        {
+            i = subtreeEnd[i];
+            continue;
+        }
+        lods[i] = lod;
+        
+        // The subtree's world matrices, in entry order, are the bones.
+        if (skin && source[i] == skin->getRoot() && subtreeEnd[i] - i == skin->getBoneCount())
+        {
+            skin->add(&world[i], lod);
+        }
+        
+        for (int leaf = firstLeaf[i]; leaf < firstLeaf[i + 1]; leaf++)
+        {
+            if (!skin || !skin->covers(leaves[leaf]))
+            {
+                leaves[leaf]->draw(world[i], context, lod);
+            }
+        }
+        i++;
+    }
+}
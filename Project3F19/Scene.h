@@ -0,0 +1,87 @@
+#ifndef _SCENE_H_
+#define _SCENE_H_
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+#include "Node.h"
+#include "Transform.h"
+#include "DrawContext.h"
+#include "OcclusionCuller.h"
+#include "SkinnedMesh.h"
+#include "../Common/SphereCuller.h"
+#include "../Common/SphereBvh.h"
+#include "../Common/JobSystem.h"
+
+// The Transform tree flattened into arrays, one entry per path from the root
+// so a shared subtree like the robot gets a copy under each parent. Entries
+// are stored parent before child, so world matrices come out of one linear
+// pass, and a subtree is the run of entries up to subtreeEnd.
+//
+// The Transforms stay the way the scene is built. Changing one's M marks its
+// entries dirty, and update() recomputes only those subtrees, so everything
+// that didn't move keeps last frame's world matrices. Animated entries are
+// instead posed from the time every update, each robot a little ahead of
+// the last, with the independent subtrees spread across threads.
+class Scene
+{
+private:
+    std::vector<glm::mat4> local;
+    std::vector<glm::mat4> world;
+    std::vector<int> parent;
+    // One past the last entry of each subtree.
+    std::vector<int> subtreeEnd;
+    std::vector<Transform*> source;
+    // Entries whose local matrix changed since the last update, each listed
+    // once.
+    std::vector<int> dirty;
+    std::vector<uint8_t> isDirty;
+    // Leaf nodes (Geometry, BoundingSphere) under each entry are
+    // leaves[firstLeaf[i]] up to leaves[firstLeaf[i + 1]].
+    std::vector<int> firstLeaf;
+    std::vector<Node*> leaves;
+    // Seconds each entry's animation runs ahead, the same under a robot.
+    std::vector<float> timeOffset;
+    // Animated entries not under another one, whose subtrees are posed and
+    // recomputed every update, and how many entries those cover.
+    std::vector<int> animationRoots;
+    unsigned animatedEntries;
+    // Level of detail picked for each entry during draw.
+    std::vector<int> lods;
+    // Entries culled against the frustum, their bounding spheres gathered
+    // whenever one of them moves, and which were visible this frame.
+    std::vector<int> cullable;
+    std::vector<int> sphereIndex;
+    SphereSet spheres;
+    bool spheresMoved;
+    SphereBvh bvh;
+    std::vector<uint32_t> sphereVisible;
+    // Of those, which were hidden behind last frame's depth.
+    std::vector<uint32_t> sphereOccluded;
+    
+    int add(Transform* transform, int parentIndex);
+    // Bounding spheres of the cullable entries from their world matrices.
+    void gatherSpheres(JobSystem* jobs);
+public:
+    // Flattens everything under root, replacing whatever was built before.
+    void build(Transform* root);
+    void markDirty(const std::vector<int>& entries);
+    // A cullable Transform's bounds changed, so the spheres need gathering
+    // again.
+    void boundsChanged() { spheresMoved = true; }
+    // Copies changed local matrices, poses animated entries for time, and
+    // recomputes the world matrices of those entries and their descendants;
+    // returns how many were computed. With jobs, the animated subtrees and
+    // the bounding spheres are split across its threads.
+    unsigned update(double time = 0.0, JobSystem* jobs = nullptr);
+    // Same culling, levels of detail, and leaf draws as Transform::draw,
+    // walking the arrays instead of the tree.
+    void draw(DrawContext& context);
+    size_t size() const { return local.size(); }
+    // Cull through the hierarchy rather than testing every sphere.
+    static bool bvhOn;
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include "SkinnedMesh.h"
+
+#include <algorithm>
+#include <glm/gtx/transform.hpp>
+
+SkinnedMesh::SkinnedMesh(Transform* root, GLuint shaderProgram)
+    : root(root), program(shaderProgram), lodCount(1)
+{
+    // Each level of detail takes every part at that level, or its last one
+    // if it has fewer.
+    std::vector<Vertex> vertices;
+    std::vector<unsigned> indices[maxMeshLods];
+    boneCount = addBones(root, 0, vertices, indices);
+    
+    std::vector<unsigned> merged;
+    for (int i = 0; i < lodCount; i++)
+    {
+        lods[i].indexOffset = (uint32_t)merged.size();
+        lods[i].indexCount = (uint32_t)indices[i].size();
+        merged.insert(merged.end(), indices[i].begin(), indices[i].end());
+    }
+    
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    // An integer attribute, so the bone index isn't converted to float.
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(Vertex), (void*)offsetof(Vertex, bone));
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, merged.size() * sizeof(unsigned), merged.data(), GL_STATIC_DRAW);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    
+    // Four RGBA32F texels per matrix, one column each.
+    glGenBuffers(1, &boneBuffer);
+    glGenTextures(1, &boneTexture);
+    glBindBuffer(GL_TEXTURE_BUFFER, boneBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 0, NULL, GL_STREAM_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, boneTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, boneBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    
+    ShaderProgram& skinned = ShaderProgram::get(program);
+    skinned.set("bones", 0);
+    skinned.set("boneCount", boneCount);
+    
+    printf("Skinned %zu parts into %zu vertices and %d bones\n", parts.size(), vertices.size(), boneCount);
+}
+
+SkinnedMesh::~SkinnedMesh()
+{
+    glDeleteBuffers(1, &vbo);
+    glDeleteBuffers(1, &ebo);
+    glDeleteBuffers(1, &boneBuffer);
+    glDeleteTextures(1, &boneTexture);
+    glDeleteVertexArrays(1, &vao);
+    
+    ShaderProgram::release(program);
+}
+
+int SkinnedMesh::addBones(Transform* transform, int bone, std::vector<Vertex>& vertices,
+                          std::vector<unsigned>* indices)
+{
+    // Leaves first, then child Transforms depth first, as Scene::add does.
+    const std::vector<Node*>& children = transform->getChildren();
+    for (Node* child : children)
+    {
+        Geometry* geometry = dynamic_cast<Geometry*>(child);
+        if (!geometry)
+        {
+            continue;
+        }
+        
+        // The same arrays the Geometry uploaded, from the binary cache.
+        MeshCache mesh;
+        if (!mesh.load(geometry->getFilename(), MESH_LAYOUT_WELDED, 7.5f, true, maxMeshLods))
+        {
+            continue;
+        }
+        parts.push_back(geometry);
+        
+        unsigned first = (unsigned)vertices.size();
+        for (size_t i = 0; i < mesh.positionCount(); i++)
+        {
+            Vertex vertex;
+            vertex.position = mesh.positions()[i];
+            vertex.normal = mesh.normals()[i];
+            vertex.bone = (uint32_t)bone;
+            vertices.push_back(vertex);
+        }
+        
+        int levels = (int)mesh.lodCount();
+        lodCount = std::max(lodCount, levels);
+        for (int i = 0; i < (int)maxMeshLods; i++)
+        {
+            MeshLod level = mesh.lod(std::min(i, levels - 1));
+            for (uint32_t j = 0; j < level.indexCount; j++)
+            {
+                indices[i].push_back(first + mesh.indices()[level.indexOffset + j]);
+            }
+        }
+    }
+    
+    int next = bone + 1;
+    for (Node* child : children)
+    {
+        Transform* childTransform = dynamic_cast<Transform*>(child);
+        if (childTransform)
+        {
+            next = addBones(childTransform, next, vertices, indices);
+        }
+    }
+    return next;
+}
+
+bool SkinnedMesh::covers(const Node* leaf) const
+{
+    return std::find(parts.begin(), parts.end(), leaf) != parts.end();
+}
+
+void SkinnedMesh::add(const glm::mat4* bones, int lod)
+{
+    lod = lod < lodCount ? lod : lodCount - 1;
+    instances[lod].insert(instances[lod].end(), bones, bones + boneCount);
+}
+
+void SkinnedMesh::queueInstances(RenderQueue& queue)
+{
+    size_t total = 0;
+    for (int i = 0; i < lodCount; i++)
+    {
+        total += instances[i].size();
+    }
+    if (total == 0)
+    {
+        return;
+    }
+    
+    // Orphan the buffer and write each level's matrices after the last.
+    glBindBuffer(GL_TEXTURE_BUFFER, boneBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, total * sizeof(glm::mat4), NULL, GL_STREAM_DRAW);
+    size_t first = 0;
+    for (int i = 0; i < lodCount; i++)
+    {
+        std::vector<glm::mat4>& bones = instances[i];
+        if (bones.empty())
+        {
+            continue;
+        }
+        glBufferSubData(GL_TEXTURE_BUFFER, first * sizeof(glm::mat4), bones.size() * sizeof(glm::mat4), bones.data());
+        
+        ranges[i].mesh = this;
+        ranges[i].first = (int)(first / boneCount);
+        
+        DrawPacket packet;
+        packet.program = program;
+        packet.vao = vao;
+        packet.mode = GL_TRIANGLES;
+        packet.count = lods[i].indexCount;
+        packet.indexOffset = lods[i].indexOffset * sizeof(unsigned);
+        packet.instanceCount = (GLsizei)(bones.size() / boneCount);
+        packet.model = glm::mat4(1.0f);
+        packet.depth = 0.0f;
+        packet.bindMaterial = bindInstances;
+        packet.material = &ranges[i];
+        queue.push(packet);
+        
+        first += bones.size();
+        bones.clear();
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void SkinnedMesh::bindInstances(ShaderProgram& program, const void* material)
+{
+    const InstanceRange* range = (const InstanceRange*)material;
+    program.set("firstInstance", range->first);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, range->mesh->boneTexture);
+}
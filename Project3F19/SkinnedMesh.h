@@ -0,0 +1,87 @@
+#ifndef _SKINNED_MESH_H_
+#define _SKINNED_MESH_H_
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#else
+#include <GL/glew.h>
+#endif
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Node.h"
+#include "Transform.h"
+#include "Geometry.h"
+#include "../Common/MeshCache.h"
+#include "../Common/RenderQueue.h"
+
+// Every Geometry under a Transform merged into one mesh, each vertex tagged
+// with the Transform it hangs off as its bone. Bones are numbered in the
+// order Scene lays out a subtree's entries, so the world matrices of a copy
+// of the subtree, as they sit in Scene, are its bone matrices.
+//
+// Bone matrices of all the copies drawn in a frame go into a texture buffer
+// that the vertex shader reads by instance, and each level of detail is one
+// instanced draw.
+class SkinnedMesh
+{
+private:
+    struct Vertex
+    {
+        glm::vec3 position;
+        glm::vec3 normal;
+        uint32_t bone;
+    };
+    
+    Transform* root;
+    int boneCount;
+    // Leaves drawn by the skinned mesh instead of on their own.
+    std::vector<const Node*> parts;
+    
+    GLuint program;
+    GLuint vao;
+    GLuint vbo;
+    GLuint ebo;
+    MeshLod lods[maxMeshLods];
+    int lodCount;
+    
+    // Bone matrices collected for each level of detail, boneCount per
+    // instance, streamed into boneBuffer by queueInstances.
+    std::vector<glm::mat4> instances[maxMeshLods];
+    GLuint boneBuffer;
+    GLuint boneTexture;
+    
+    // Where each level's instances start in boneBuffer this frame.
+    struct InstanceRange
+    {
+        const SkinnedMesh* mesh;
+        int first;
+    };
+    InstanceRange ranges[maxMeshLods];
+    
+    // Adds the parts under transform, which is bone number bone, and returns
+    // the next free bone number.
+    int addBones(Transform* transform, int bone, std::vector<Vertex>& vertices,
+                 std::vector<unsigned>* indices);
+    static void bindInstances(ShaderProgram& program, const void* material);
+public:
+    SkinnedMesh(Transform* root, GLuint shaderProgram);
+    ~SkinnedMesh();
+    SkinnedMesh(const SkinnedMesh&) = delete;
+    SkinnedMesh& operator=(const SkinnedMesh&) = delete;
+    
+    Transform* getRoot() const { return root; }
+    int getBoneCount() const { return boneCount; }
+    bool covers(const Node* leaf) const;
+    // Collects one copy posed by boneCount world matrices.
+    void add(const glm::mat4* bones, int lod);
+    // Uploads every copy collected since the last call and queues one
+    // instanced draw per level of detail.
+    void queueInstances(RenderQueue& queue);
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "SwingChannel.h"
+
+#include <cmath>
+
+SwingChannel::SwingChannel()
+    : pivot(0.0f), axis(1.0f, 0.0f, 0.0f), amplitude(0.0f), speed(0.0f), phase(0.0f)
+{
+}
+
+SwingChannel::SwingChannel(const glm::vec3& pivot, const glm::vec3& axis, float amplitude, float speed, float phase)
+    : pivot(pivot), axis(glm::normalize(axis)), amplitude(amplitude), speed(speed), phase(phase)
+{
+}
+
+float SwingChannel::angle(double time) const
+{
+    if (amplitude <= 0.0f)
+    {
+        return 0.0f;
+    }
+    
+    // A swing is four quarters of amplitude each: up, down twice, up. In
+    // double so long running times keep their precision.
+    double quarters = time * speed / amplitude + 4.0 * phase;
+    double u = std::fmod(quarters, 4.0);
+    if (u < 0.0)
+    {
+        u += 4.0;
+    }
+    double s = u < 1.0 ? u : (u < 3.0 ? 2.0 - u : u - 4.0);
+    return (float)(s * amplitude);
+}
+
+glm::mat4 SwingChannel::evaluate(double time) const
+{
+    return glm::translate(pivot) * glm::rotate(angle(time), axis) * glm::translate(-pivot);
+}
+
+Bounds SwingChannel::sweep(const Bounds& bounds) const
+{
+    if (bounds.empty() || amplitude <= 0.0f)
+    {
+        return bounds;
+    }
+    
+    // The sphere's center circles the point of the axis nearest it.
+    glm::vec3 onAxis = pivot + axis * glm::dot(bounds.center - pivot, axis);
+    Bounds swept;
+    swept.center = onAxis;
+    swept.radius = glm::length(bounds.center - onAxis) + bounds.radius;
+    swept.min = onAxis - glm::vec3(swept.radius);
+    swept.max = onAxis + glm::vec3(swept.radius);
+    return swept;
+}
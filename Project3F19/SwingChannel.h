@@ -0,0 +1,35 @@
+#ifndef _SWING_CHANNEL_H_
+#define _SWING_CHANNEL_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include "../Common/Bounds.h"
+
+// A limb swinging back and forth about a pivot, as a function of time alone:
+// the angle climbs from 0 to amplitude, falls to -amplitude and climbs back,
+// at a constant speed. Any time can be sampled directly, in any order and
+// from any thread, without stepping through the frames before it.
+struct SwingChannel
+{
+    glm::vec3 pivot;
+    glm::vec3 axis;
+    // Radians, and radians per second.
+    float amplitude;
+    float speed;
+    // Fraction of a swing the channel is ahead by; 0.5 starts at 0 heading
+    // towards -amplitude.
+    float phase;
+
+    SwingChannel();
+    SwingChannel(const glm::vec3& pivot, const glm::vec3& axis, float amplitude, float speed, float phase = 0.0f);
+
+    float angle(double time) const;
+    // Rotation by angle(time) about the pivot.
+    glm::mat4 evaluate(double time) const;
+    // Bounds enclosing bounds at every angle, a sphere around its sweep
+    // about the axis.
+    Bounds sweep(const Bounds& bounds) const;
+};
+
+#endif
@@ -1,14 +1,34 @@
 #include "Transform.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
 
 bool Transform::boundingSphereOn = false;
 bool Transform::cullingOn = false;
+bool Transform::lodOn = true;
+
+// Smallest on-screen radius, in pixels, at which a robot still uses each
+// level of detail; anything smaller uses the last one.
+static const float lodPixels[] = { 120.0f, 60.0f, 30.0f };
 
 Transform::Transform(glm::mat4 M, GLuint shaderProgram, int id)
 {
     this->M = M;
     this->setShaderProgram(shaderProgram);
     this->id = id;
-    degree = 0.0f;
+    
+    // Arms swing 30 degrees a second and legs 180, both out to 50 degrees
+    // about the shoulder or hip.
+    animated = id >= 3 && id <= 6;
+    if (animated)
+    {
+        float speed = id <= 4 ? 30.0f : 180.0f;
+        swing = SwingChannel(glm::vec3(0, 5, 0), glm::vec3(1, 0, 0), glm::radians(50.0f), glm::radians(speed));
+    }
+    scene = nullptr;
+    content = emptyBounds();
+    bounds = emptyBounds();
 }
 
 Transform::~Transform()
@@ -19,96 +39,156 @@ Transform::~Transform()
     }
 }
 
-int Transform::draw(glm::mat4 C, std::vector<std::pair<glm::vec3, glm::vec3>> frustumPlanes)
+void Transform::draw(const glm::mat4& C, DrawContext& context, int lod)
+{
+    // Counted whether culled or not, so each robot gets the offset the
+    // flattened scene gives it.
+    if (isCullable())
+    {
+        context.timeOffset = timeOffset(context.robotsReached++);
+    }
+    if (!visible(C, context, lod))
+    {
+        return;
+    }
+    
+    // The robot is shared, so each copy is posed as it is drawn.
+    glm::mat4 newM = C * (animated ? pose(context.time + context.timeOffset) : M);
+    context.recomputedMatrices++;
+    for (Node* node: children)
+    {
+        node->draw(newM, context, lod);
+    }
+}
+
+bool Transform::visible(const glm::mat4& C, DrawContext& context, int& lod, bool tested)
 {
     if (id == 2 && !boundingSphereOn)
     {
-        return 0;
+        return false;
     }
     
-    if (id == 1 && cullingOn)
+    Bounds worldBounds = id == 1 ? transformBounds(bounds, C) : bounds;
+    if (id == 1 && cullingOn && !tested
+        && !sphereInFrustum(context.frustumPlanes, worldBounds.center, worldBounds.radius))
     {
-        center = glm::vec3(C[3][0], C[3][1], C[3][2]);
-        //for (std::pair<glm::vec3, glm::vec3> plane: frustumPlanes)
-        //{
-        for(int i = 0; i < frustumPlanes.size(); i++)
+        context.culledRobots++;
+        return false;
+    }
+    
+    if (id == 1 && lodOn)
+    {
+        float distance = glm::length(worldBounds.center - context.eye);
+        float pixels = worldBounds.radius * context.lodScale / glm::max(distance, 1.0f);
+        lod = 0;
+        while (lod < (int)(sizeof(lodPixels) / sizeof(lodPixels[0])) && pixels < lodPixels[lod])
         {
-            auto plane = frustumPlanes[i];
-            float dist = glm::dot(center, plane.second) - glm::dot(plane.first, plane.second);
-            if (dist > radius)
-            {
-                return 0;
-            }
+            lod++;
         }
     }
     
-    int count = 0;
-    glm::mat4 newM = C * M;
-    for (Node* node: children)
+    if (id == 1)
     {
-        count += node->draw(newM, frustumPlanes);
+        context.visibleRobots++;
     }
-    if (id == 1)
+    return true;
+}
+
+glm::mat4 Transform::pose(double time) const
+{
+    return animated ? M * swing.evaluate(time) : M;
+}
+
+float Transform::timeOffset(int robot)
+{
+    // Spread over 10 seconds by the golden ratio, so neighbors differ.
+    float spread = (float)robot * 0.618034f;
+    return 10.0f * (spread - std::floor(spread));
+}
+
+void Transform::addChild(Node* node)
+{
+    children.push_back(node);
+    if (getShaderProgram() != -1)
     {
-        return count + 1;
+        node->setShaderProgram(getShaderProgram());
     }
-    else
+}
+
+void Transform::removeChild(Node* node)
+{
+    children.erase(std::remove(children.begin(), children.end(), node), children.end());
+}
+
+void Transform::setMatrix(const glm::mat4& M)
+{
+    // An animated node swings on top of the new matrix from here on.
+    this->M = M;
+    bounds = transformBounds(animated ? swing.sweep(content) : content, M);
+    markDirty();
+}
+
+Bounds Transform::getBounds()
+{
+    return bounds;
+}
+
+void Transform::updateBounds()
+{
+    for (Node* node: children)
     {
-        return count;
+        Transform* transform = dynamic_cast<Transform*>(node);
+        if (transform)
+        {
+            transform->updateBounds();
+        }
     }
+    fitBounds();
 }
 
-void Transform::update()
+void Transform::fitBounds()
 {
-    float rotateDegree = 0.0f;
-    switch (id)
+    Bounds previous = bounds;
+    content = emptyBounds();
+    for (Node* node: children)
     {
-        case 3:
-        case 4:
-            rotateDegree = moveDir * glm::radians(0.5f);
-            M = M * glm::translate(glm::vec3(0, 5, 0)) * glm::rotate(rotateDegree, glm::vec3(1, 0, 0)) * glm::translate(glm::vec3(0, -5, 0));
-            degree += rotateDegree;
-            if (degree > glm::radians(50.0f))
-            {
-                moveDir = -1;
-            }
-            if (degree < -glm::radians(50.0f))
-            {
-                moveDir = 1;
-            }
-            break;
-        case 5:
-        case 6:
-            rotateDegree = moveDir * glm::radians(3.0f);
-            M = M * glm::translate(glm::vec3(0, 5, 0)) * glm::rotate(rotateDegree, glm::vec3(1, 0, 0)) * glm::translate(glm::vec3(0, -5, 0));
-            degree += rotateDegree;
-            if (degree > glm::radians(50.0f))
-            {
-                moveDir = -1;
-            }
-            if (degree < -glm::radians(50.0f))
-            {
-                moveDir = 1;
-            }
-            break;
-        default:
-            break;
+        Transform* transform = dynamic_cast<Transform*>(node);
+        if (!transform || transform->id != 2)
+        {
+            mergeBounds(content, node->getBounds());
+        }
     }
+    bounds = transformBounds(animated ? swing.sweep(content) : content, M);
+    
+    // Stretch the sphere drawn for the bounds over them.
     for (Node* node: children)
     {
-        node->update();
+        Transform* transform = dynamic_cast<Transform*>(node);
+        if (transform && transform->id == 2 && !content.empty() && !transform->content.empty())
+        {
+            const Bounds& sphere = transform->content;
+            transform->setMatrix(glm::translate(content.center)
+                                 * glm::scale(glm::vec3(content.radius / sphere.radius))
+                                 * glm::translate(-sphere.center));
+        }
+    }
+    
+    bool changed = bounds.radius != previous.radius || bounds.center != previous.center;
+    if (id == 1 && changed && scene)
+    {
+        scene->boundsChanged();
     }
 }
 
-void Transform::addChild(Node* node)
+void Transform::markDirty()
 {
-    children.push_back(node);
-    if (getShaderProgram() != -1)
+    if (scene)
     {
-        node->setShaderProgram(getShaderProgram());
+        scene->markDirty(entries);
     }
 }
 
 void Transform::setMoveDir(int dir) {
-    moveDir = dir;
+    // Heading the other way is half a swing along.
+    swing.phase = dir < 0 ? 0.5f : 0.0f;
 }
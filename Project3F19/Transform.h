@@ -8,6 +8,10 @@
 #endif
 
 #include "Node.h"
+#include "SwingChannel.h"
+#include "../Common/Frustum.h"
+
+class Scene;
 
 class Transform : public Node
 {
@@ -15,19 +19,54 @@ private:
     glm::mat4 M;
     std::vector<Node*> children;
     int id;
-    int moveDir;
-    float degree;
-    glm::vec3 center;
-    float radius = 25.0f;
+    // Limbs swing on top of M, posed from the time as they are drawn.
+    SwingChannel swing;
+    bool animated;
+    // Bounds of the children, and the same after M, the node's own bounds.
+    // Nodes with id 2 only draw the bounds, so they don't count towards
+    // them and are instead fitted around them. An animated node's bounds
+    // cover its whole swing, so they hold at any time.
+    Bounds content;
+    Bounds bounds;
+    void fitBounds();
+    // The Scene this Transform was flattened into and its entries there,
+    // one per path from the root, marked dirty whenever M changes.
+    Scene* scene;
+    std::vector<int> entries;
+    void markDirty();
+    friend class Scene;
 public:
     Transform(glm::mat4 M, GLuint shaderProgram = -1, int id = 0);
     ~Transform();
-    int draw(glm::mat4 C, std::vector<std::pair<glm::vec3, glm::vec3>> frustumPlanes);
-    void update();
+    void draw(const glm::mat4& C, DrawContext& context, int lod);
     void addChild(Node* node);
+    // Detaches node without deleting it.
+    void removeChild(Node* node);
     void setMoveDir(int dir);
+    bool isAnimated() const { return animated; }
+    // M at time, without changing anything, so copies of the subtree can be
+    // posed at different times in parallel.
+    glm::mat4 pose(double time) const;
+    // Seconds the animation of the robot-th cullable subtree, in traversal
+    // order, runs ahead, so neighbors don't move in step.
+    static float timeOffset(int robot);
+    // Culls the subtree and picks its level of detail for a node with world
+    // matrix C; false if nothing under it should be drawn. tested skips the
+    // frustum test when the caller has already done it.
+    bool visible(const glm::mat4& C, DrawContext& context, int& lod, bool tested = false);
+    // Whether visible() culls this subtree against the frustum, by its
+    // bounding sphere under C.
+    bool isCullable() const { return id == 1; }
+    Bounds getBounds();
+    // Recomputes the bounds of the whole subtree, after it is built or a
+    // node's M was set.
+    void updateBounds();
+    const glm::mat4& getMatrix() const { return M; }
+    void setMatrix(const glm::mat4& M);
+    const std::vector<Node*>& getChildren() const { return children; }
     static bool boundingSphereOn;
     static bool cullingOn;
+    static bool lodOn;
 };
 
 #endif
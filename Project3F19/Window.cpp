@@ -27,10 +27,24 @@ glm::vec3 Window::up(0, 1, 0); // The up direction of the camera.
 // View matrix, defined by eye, center and up.
 glm::mat4 Window::view = glm::lookAt(Window::eye, Window::center, Window::up);
 
-float Window::hNear = 2 * tan(Window::fov / 2) * 1.0;
-float Window::wNear = hNear * float(Window::width) / (float)Window::height;
+glm::mat4 Window::cullProjection;
 
-std::vector<std::pair<glm::vec3, glm::vec3>> Window::frustumPlanes(6);
+glm::vec4 Window::frustumPlanes[6];
+float Window::lodScale = 1.0f;
+
+RenderQueue Window::renderQueue;
+
+Scene Window::scene;
+bool Window::flatSceneOn = true;
+
+OcclusionCuller* Window::occlusion;
+bool Window::occlusionOn = true;
+
+JobSystem* Window::jobs;
+
+SkinnedMesh* Window::skin;
+bool Window::skinningOn = true;
+double Window::animationTime = 0.0;
 
 bool Window::initializeObjects()
 {
@@ -52,7 +66,7 @@ bool Window::initializeObjects()
         }
     }
     
-    Transform* boundingSphere = new Transform(glm::scale(glm::vec3(2.3)), 0, 2);
+    Transform* boundingSphere = new Transform(glm::mat4(1.0), 0, 2);
     Transform* body = new Transform(glm::translate(glm::vec3(0, 0, 0)));
     Transform* head = new Transform(glm::translate(glm::vec3(0, 11.25, 0)));
     Transform* leftEye = new Transform(glm::translate(glm::vec3(2.5, -1, 6.5)) * glm::scale(glm::vec3(0.1)));
@@ -102,6 +116,26 @@ bool Window::initializeObjects()
       
     glBindBufferRange(GL_UNIFORM_BUFFER, 0, uboMatrices, 0, 2 * sizeof(glm::mat4));
     
+    // Bounds of every part from its mesh, and the bounding sphere fitted
+    // around them.
+    world->updateBounds();
+    
+    // One entry per robot part per robot, laid out for linear traversal and
+    // animated across every core.
+    scene.build(world);
+    jobs = new JobSystem();
+    
+    // The robot's parts merged into one mesh posed by its Transforms, so
+    // the whole army draws in one instanced call per level of detail.
+    GLuint skinnedProgram = LoadShaders("shaders/skinned.vert", "shaders/shader.frag");
+    glUniformBlockBinding(skinnedProgram, glGetUniformBlockIndex(skinnedProgram, "Matrices"), 0);
+    skin = new SkinnedMesh(robot, skinnedProgram);
+    
+    // Depth pyramid of last frame's draws, against which robots that pass
+    // the frustum are tested.
+    occlusion = new OcclusionCuller();
+    occlusion->resize(width, height);
+    
     return true;
 }
 
@@ -109,6 +143,9 @@ void Window::cleanUp()
 {
     // Deallcoate the objects.
     delete world;
+    delete occlusion;
+    delete jobs;
+    delete skin;
 }
 
 GLFWwindow* Window::createWindow(int width, int height)
@@ -181,14 +218,18 @@ void Window::resizeCallback(GLFWwindow* window, int width, int height)
     glViewport(0, 0, width, height);
     
     // Set the projection matrix.
-    Window::projection = glm::perspective(fov, double(width) / (double)height, 1.0, 1000.0);
+    updateProjection();
     
-    calculateFrustumPlanes();
+    if (occlusion)
+    {
+        occlusion->resize(width, height);
+    }
 }
 
 void Window::idleCallback()
 {
-    robot->update();
+    // Both traversals pose the robots from the time as they go.
+    animationTime = glfwGetTime();
 }
 
 void Window::displayCallback(GLFWwindow* window)
@@ -201,8 +242,64 @@ void Window::displayCallback(GLFWwindow* window)
     glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(view));
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
     
-    int count = world->draw(glm::mat4(1.0), frustumPlanes);
-    glfwSetWindowTitle(window, (windowTitle + std::to_string(count)).c_str());
+    // Taken from the matrices every frame, so any camera change is picked up.
+    calculateFrustumPlanes();
+    
+    // Nodes queue their draws, which are then sorted by state and issued.
+    // Nothing in here allocates once the queues have grown to size.
+    DrawContext context;
+    for (int i = 0; i < 6; i++)
+    {
+        context.frustumPlanes[i] = frustumPlanes[i];
+    }
+    context.viewProjection = projection * view;
+    context.eye = eye;
+    context.lodScale = lodScale;
+    context.time = animationTime;
+    context.timeOffset = 0.0f;
+    context.robotsReached = 0;
+    context.queue = &renderQueue;
+    // Only the flat traversal tests occlusion, after its frustum pass.
+    bool occluding = occlusionOn && Transform::cullingOn && flatSceneOn;
+    context.occlusion = occluding ? occlusion : nullptr;
+    // Bones come from the flat scene's world matrices.
+    context.skin = skinningOn && flatSceneOn ? skin : nullptr;
+    context.visibleRobots = 0;
+    context.culledRobots = 0;
+    context.occludedRobots = 0;
+    context.recomputedMatrices = 0;
+    
+    renderQueue.eye = eye;
+    if (flatSceneOn)
+    {
+        context.recomputedMatrices = scene.update(animationTime, jobs);
+        scene.draw(context);
+    }
+    else
+    {
+        world->draw(glm::mat4(1.0), context, 0);
+    }
+    Geometry::queueInstances(renderQueue);
+    if (context.skin)
+    {
+        skin->queueInstances(renderQueue);
+    }
+    renderQueue.submit(occluding);
+    RenderQueueStats stats = renderQueue.stats();
+    
+    // The same draws again into the pyramid, as next frame's occluders.
+    if (occluding)
+    {
+        occlusion->beginDepth(projection * view);
+        renderQueue.submit();
+        occlusion->endDepth();
+    }
+    
+    char title[256];
+    snprintf(title, sizeof(title), "%s%d | Occluded: %d | Draws: %u | Binds saved: %u | Matrices: %d",
+             windowTitle.c_str(), context.visibleRobots, context.occludedRobots, stats.packets,
+             stats.programBindsSaved + stats.vaoBindsSaved, context.recomputedMatrices);
+    glfwSetWindowTitle(window, title);
     
     // Gets events, including input such as keyboard and mouse or window resizing.
     glfwPollEvents();
@@ -227,12 +324,26 @@ void Window::keyCallback(GLFWwindow* window, int key, int scancode, int action,
             case GLFW_KEY_C:
                 Transform::cullingOn = !Transform::cullingOn;
                 break;
+            case GLFW_KEY_L:
+                Transform::lodOn = !Transform::lodOn;
+                break;
+            case GLFW_KEY_I:
+                Geometry::instancingOn = !Geometry::instancingOn;
+                break;
+            case GLFW_KEY_F:
+                flatSceneOn = !flatSceneOn;
+                break;
+            case GLFW_KEY_H:
+                Scene::bvhOn = !Scene::bvhOn;
+                break;
+            case GLFW_KEY_O:
+                occlusionOn = !occlusionOn;
+                break;
+            case GLFW_KEY_S:
+                skinningOn = !skinningOn;
+                break;
             case GLFW_KEY_D:
                 demoMode = !demoMode;
-                if (!demoMode)
-                {
-                    calculateFrustumPlanes();
-                }
             default:
                 break;
         }
@@ -254,8 +365,6 @@ void Window::positionCallback(GLFWwindow* window, double xpos, double ypos)
         center -= eye;
         center = rotate(center, rotationAngle, rotationAxis);
         center += eye;
-
-        calculateFrustumPlanes();
     }
     view = glm::lookAt(Window::eye, Window::center, Window::up);
     
@@ -291,8 +400,14 @@ void Window::scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
         fov += glm::radians(0.5);
     }
     
+    updateProjection();
+}
+
+void Window::updateProjection()
+{
     projection = glm::perspective(fov, double(width) / (double)height, 1.0, 1000.0);
-    calculateFrustumPlanes();
+    // Levels of detail are picked by projected size, so they follow the zoom.
+    lodScale = height / (2.0f * tan(fov / 2));
 }
 
 glm::vec3 Window::trackBallMapping(glm::vec2 point)
@@ -315,42 +430,11 @@ glm::vec3 Window::trackBallMapping(glm::vec2 point)
 
 void Window::calculateFrustumPlanes()
 {
+    // Demo mode keeps culling with the projection it was started with, so
+    // zooming out shows what gets culled.
     if (!demoMode)
     {
-        hNear = 2 * tan(fov / 2) * 1.0;
-        wNear = hNear * float(width) / (float)height;
+        cullProjection = projection;
     }
-    
-    glm::vec3 d = glm::normalize(center - eye);
-    glm::vec3 right = glm::normalize(glm::cross(d, up));
-    
-    // near plane
-    frustumPlanes[0] = std::pair<glm::vec3, glm::vec3>(eye + d * 1.0f, -d);
-    
-    // far plane
-    frustumPlanes[1] = std::pair<glm::vec3, glm::vec3>(eye + d * 1000.0f, d);
-    
-    // right plane
-    glm::vec3 rightPoint = frustumPlanes[0].first + right * wNear / 2.0f;
-    glm::vec3 a = glm::normalize(rightPoint - eye);
-    glm::vec3 rightNormal = glm::cross(a, up);
-    frustumPlanes[2] = std::pair<glm::vec3, glm::vec3>(rightPoint, rightNormal);
-    
-    // left plane
-    glm::vec3 leftPoint = frustumPlanes[0].first - right * wNear / 2.0f;
-    glm::vec3 b = glm::normalize(leftPoint - eye);
-    glm::vec3 leftNormal = glm::cross(up, b);
-    frustumPlanes[3] = std::pair<glm::vec3, glm::vec3>(leftPoint, leftNormal);
-    
-    // top plane
-    glm::vec3 topPoint = frustumPlanes[0].first + up * hNear / 2.0f;
-    glm::vec3 c = glm::normalize(topPoint - eye);
-    glm::vec3 topNormal = glm::cross(right, c);
-    frustumPlanes[4] = std::pair<glm::vec3, glm::vec3>(topPoint, topNormal);
-    
-    // bottom plane
-    glm::vec3 bottomPoint = frustumPlanes[0].first - up * hNear / 2.0f;
-    glm::vec3 e = glm::normalize(bottomPoint - eye);
-    glm::vec3 bottomNormal = glm::cross(e, right);
-    frustumPlanes[5] = std::pair<glm::vec3, glm::vec3>(bottomPoint, bottomNormal);
+    extractFrustumPlanes(cullProjection * view, frustumPlanes);
 }
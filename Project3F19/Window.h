@@ -25,6 +25,13 @@
 #include "Transform.h"
 #include "Geometry.h"
 #include "BoundingSphere.h"
+#include "Scene.h"
+#include "OcclusionCuller.h"
+#include "SkinnedMesh.h"
+#include "DrawContext.h"
+#include "../Common/RenderQueue.h"
+#include "../Common/Frustum.h"
+#include "../Common/JobSystem.h"
 
 struct Material {
     glm::vec3 ambient;
@@ -51,9 +58,18 @@ public:
     static double fov;
     static glm::mat4 view;
     static glm::vec3 eye, center, up;
-    static float hNear;
-    static float wNear;
-    static std::vector<std::pair<glm::vec3, glm::vec3>> frustumPlanes;
+    static glm::mat4 cullProjection;
+    static glm::vec4 frustumPlanes[6];
+    static float lodScale;
+    static RenderQueue renderQueue;
+    static Scene scene;
+    static bool flatSceneOn;
+    static OcclusionCuller* occlusion;
+    static bool occlusionOn;
+    static JobSystem* jobs;
+    static SkinnedMesh* skin;
+    static bool skinningOn;
+    static double animationTime;
     
     static bool initializeObjects();
     static void cleanUp();
@@ -65,6 +81,8 @@ public:
     static void positionCallback(GLFWwindow* window, double xpos, double ypos);
     static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
     static void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+    // Projection and lodScale from fov and the window size.
+    static void updateProjection();
     static glm::vec3 trackBallMapping(glm::vec2 point);
     static void calculateFrustumPlanes();
 };
@@ -105,3 +105,41 @@ GLuint LoadShaders(const char * vertexFilePath, const char * fragmentFilePath)
     
     return programID;
 }
+
+GLuint LoadFeedbackShader(const char * vertexFilePath, const char * varying)
+{
+    GLuint vertexShaderID = LoadSingleShader(vertexFilePath, vertex);
+    if (vertexShaderID == 0) return 0;
+    
+    GLint Result = GL_FALSE;
+    int InfoLogLength;
+    
+    // Link the program, capturing the varying.
+    printf("Linking program\n");
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glTransformFeedbackVaryings(programID, 1, &varying, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(programID);
+    
+    // Check the program.
+    glGetProgramiv(programID, GL_LINK_STATUS, &Result);
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+    if (InfoLogLength > 0 || Result != GL_TRUE)
+    {
+        std::vector<char> ProgramErrorMessage(InfoLogLength + 1);
+        glGetProgramInfoLog(programID, InfoLogLength, NULL, ProgramErrorMessage.data());
+        std::string msg(ProgramErrorMessage.begin(), ProgramErrorMessage.end());
+        std::cerr << msg << std::endl;
+        glDeleteProgram(programID);
+        return 0;
+    }
+    else
+    {
+        printf("Successfully linked program!\n");
+    }
+    
+    glDetachShader(programID, vertexShaderID);
+    glDeleteShader(vertexShaderID);
+    
+    return programID;
+}
@@ -15,5 +15,8 @@
 #include <algorithm>
 
 GLuint LoadShaders(const char * vertex_file_path, const char * fragment_file_path);
+// A program with only a vertex shader, whose output varying is captured by
+// transform feedback.
+GLuint LoadFeedbackShader(const char * vertex_file_path, const char * varying);
 
 #endif
@@ -0,0 +1,37 @@
+#version 330 core
+
+// The level below the one being written, as the texture's base level.
+uniform sampler2D depth;
+
+float fetch(ivec2 coord, ivec2 size)
+{
+    return texelFetch(depth, min(coord, size - 1), 0).r;
+}
+
+void main()
+{
+    // Each texel keeps the farthest depth of the ones it covers, so nothing
+    // it covers can be behind it.
+    ivec2 size = textureSize(depth, 0);
+    ivec2 coord = ivec2(gl_FragCoord.xy) * 2;
+    float farthest = max(max(fetch(coord, size), fetch(coord + ivec2(1, 0), size)),
+                         max(fetch(coord + ivec2(0, 1), size), fetch(coord + ivec2(1, 1), size)));
+    
+    // With an odd size the last texel of a row or column covers three.
+    bool extraX = (size.x & 1) != 0 && coord.x + 3 == size.x;
+    bool extraY = (size.y & 1) != 0 && coord.y + 3 == size.y;
+    if (extraX)
+    {
+        farthest = max(farthest, max(fetch(coord + ivec2(2, 0), size), fetch(coord + ivec2(2, 1), size)));
+    }
+    if (extraY)
+    {
+        farthest = max(farthest, max(fetch(coord + ivec2(0, 2), size), fetch(coord + ivec2(1, 2), size)));
+    }
+    if (extraX && extraY)
+    {
+        farthest = max(farthest, fetch(coord + ivec2(2, 2), size));
+    }
+    
+    gl_FragDepth = farthest;
+}
@@ -0,0 +1,58 @@
+#version 330 core
+
+// One bounding sphere per vertex: center and radius.
+layout (location = 0) in vec4 sphere;
+
+// The matrix and depth pyramid of the frame the occluders were drawn in.
+uniform mat4 viewProjection;
+uniform sampler2D depthPyramid;
+uniform int levels;
+
+// Captured by transform feedback, 1 unless the sphere is entirely behind
+// what was drawn.
+flat out uint visible;
+
+void main()
+{
+    // Screen rectangle and nearest depth of the cube around the sphere.
+    vec3 low = vec3(1.0);
+    vec3 high = vec3(-1.0);
+    for (int i = 0; i < 8; i++)
+    {
+        vec3 offset = vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = viewProjection * vec4(sphere.xyz + offset * sphere.w, 1.0);
+        if (clip.w <= 0.0)
+        {
+            // Reaches behind the camera; nothing to compare against.
+            visible = 1u;
+            return;
+        }
+        vec3 ndc = clip.xyz / clip.w;
+        low = min(low, ndc);
+        high = max(high, ndc);
+    }
+    vec2 lowUv = clamp(low.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2 highUv = clamp(high.xy * 0.5 + 0.5, 0.0, 1.0);
+    float nearest = low.z * 0.5 + 0.5;
+    
+    // The level where the rectangle is at most a texel wide, so the texels
+    // under its four corners cover all of it.
+    ivec2 baseSize = textureSize(depthPyramid, 0);
+    vec2 pixels = (highUv - lowUv) * vec2(baseSize);
+    int level = int(ceil(log2(max(max(pixels.x, pixels.y), 1.0))));
+    level = min(level, levels - 1);
+    
+    // Level sizes halve rounding down, as the pyramid was built, with the
+    // last texel of an odd row or column covering the one left over. So
+    // find the base texels first and shift them down, which lands on the
+    // texel that covers each, rather than scaling uv to the level.
+    ivec2 size = max(baseSize >> level, ivec2(1));
+    ivec2 lowTexel = min(min(ivec2(lowUv * vec2(baseSize)), baseSize - 1) >> level, size - 1);
+    ivec2 highTexel = min(min(ivec2(highUv * vec2(baseSize)), baseSize - 1) >> level, size - 1);
+    float farthest = max(max(texelFetch(depthPyramid, lowTexel, level).r,
+                             texelFetch(depthPyramid, ivec2(highTexel.x, lowTexel.y), level).r),
+                         max(texelFetch(depthPyramid, ivec2(lowTexel.x, highTexel.y), level).r,
+                             texelFetch(depthPyramid, highTexel, level).r));
+    
+    visible = nearest <= farthest ? 1u : 0u;
+}
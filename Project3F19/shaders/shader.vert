@@ -19,8 +19,32 @@ layout (std140) uniform Matrices
 };
 uniform mat4 model;
 
+// Instanced draws take the model matrix per instance instead.
+layout (location = 2) in mat4 instanceModel;
+uniform bool instanced;
+
+// Quantized vertices (see Common/VertexFormat.h) store positions in [-1, 1]
+// across the bounding box and octahedral normals in aNormal.xy.
+uniform bool quantized;
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+	{
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(n);
+}
+
 void main()
 {
-	normal = mat3(transpose(inverse(model))) * aNormal;
-    gl_Position = projection * view * vec4(vec3(model * vec4(position, 1.0)), 1.0);
+	vec3 vertexPos = quantized ? position * positionScale + positionOffset : position;
+	vec3 vertexNormal = quantized ? decodeOctahedral(aNormal.xy) : aNormal;
+	mat4 modelMatrix = instanced ? instanceModel : model;
+
+	normal = mat3(transpose(inverse(modelMatrix))) * vertexNormal;
+    gl_Position = projection * view * vec4(vec3(modelMatrix * vec4(vertexPos, 1.0)), 1.0);
 }
@@ -0,0 +1,35 @@
+#version 330 core
+
+// A vertex of the merged robot and the part it belongs to.
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in uint bone;
+
+out vec3 normal;
+
+layout (std140) uniform Matrices
+{
+    mat4 projection;
+    mat4 view;
+};
+
+// Bone matrices of every instance, boneCount per instance and four texels
+// (columns) per matrix. Instances of this draw start at firstInstance.
+uniform samplerBuffer bones;
+uniform int boneCount;
+uniform int firstInstance;
+
+mat4 boneMatrix(int index)
+{
+    int texel = index * 4;
+    return mat4(texelFetch(bones, texel), texelFetch(bones, texel + 1),
+                texelFetch(bones, texel + 2), texelFetch(bones, texel + 3));
+}
+
+void main()
+{
+    mat4 modelMatrix = boneMatrix((firstInstance + gl_InstanceID) * boneCount + int(bone));
+    
+    normal = mat3(transpose(inverse(modelMatrix))) * aNormal;
+    gl_Position = projection * view * modelMatrix * vec4(position, 1.0);
+}
@@ -1,5 +1,22 @@
 #include "BezierCurve.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "../Common/CubicBatch.h"
+
+// Segments of the arc length table, each integrated to within a relative
+// arcLengthTolerance. Enough of them that interpolating between entries is
+// as close as the integration, so lookups never integrate.
+static const int arcLengthSegments = 64;
+static const float arcLengthTolerance = 1e-5f;
+
+// 5 point Gauss-Legendre nodes and weights on [-1, 1], exact for
+// polynomials up to degree 9.
+static const float gaussNodes[5] = { 0.0f, -0.5384693101f, 0.5384693101f, -0.9061798459f, 0.9061798459f };
+static const float gaussWeights[5] = { 0.5688888889f, 0.4786286705f, 0.4786286705f, 0.2369268851f, 0.2369268851f };
+
 BezierCurve::BezierCurve(std::vector<glm::vec3> p)
 {
     this->p = p;
@@ -8,92 +25,205 @@ BezierCurve::BezierCurve(std::vector<glm::vec3> p)
     coeff[1] = 3.0f * p[0] - 6.0f * p[1] + 3.0f * p[2];
     coeff[2] = -3.0f * p[0] + 3.0f * p[1];
     coeff[3] = p[0];
+    bounds = computeBounds(p.data(), p.size());
     
-    std::vector<glm::vec3> points;
-    
-    for (float i = 0.0f; i < 1.0f; i += 1.0f/150.0f)
-    {
-        points.push_back(getPoint(i));
-    }
-    
-    length = 150 * glm::length(getPoint(1.0f/150.0f) - getPoint(0.0f));
-    
-    indicesNum = points.size();
-    
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    
-    glBindVertexArray(vao);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(),
-                 points.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
-    
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    
-    C = glm::mat4(1.0f);
+    buildArcLengths();
     
     std::cout << "Initialized BezierCurve" << std::endl;
 }
 
-BezierCurve::~BezierCurve()
+void BezierCurve::updateCoeff()
 {
-    glDeleteBuffers(1, &vbo);
-    glDeleteVertexArrays(1, &vao);
+    coeff[0] = -p[0] + 3.0f * p[1] - 3.0f * p[2] + p[3];
+    coeff[1] = 3.0f * p[0] - 6.0f * p[1] + 3.0f * p[2];
+    coeff[2] = -3.0f * p[0] + 3.0f * p[1];
+    coeff[3] = p[0];
+    bounds = computeBounds(p.data(), p.size());
     
-    glDeleteProgram(getShaderProgram());
+    buildArcLengths();
 }
 
-void BezierCurve::draw(glm::mat4 C)
+glm::vec3 BezierCurve::getPoint(float t) const
 {
-    glUseProgram(getShaderProgram());
-    glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "model"), 1, GL_FALSE, glm::value_ptr(this->C));
-    glUniform3fv(glGetUniformLocation(getShaderProgram(), "color"), 1, glm::value_ptr(glm::vec3(0)));
-    
-    glBindVertexArray(vao);
-    glPointSize(10);
-    glDrawArrays(GL_LINE_STRIP, 0, indicesNum);
-    glBindVertexArray(0);
+    return ((coeff[0] * t + coeff[1]) * t + coeff[2]) * t + coeff[3];
 }
 
-void BezierCurve::update()
+glm::vec3 BezierCurve::getTangent(float t) const
 {
+    return (3.0f * coeff[0] * t + 2.0f * coeff[1]) * t + coeff[2];
 }
 
-void BezierCurve::updateCoeff()
+// Squared distance from point to the segment from a to b.
+static float distanceToSegment2(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b)
 {
-    coeff[0] = -p[0] + 3.0f * p[1] - 3.0f * p[2] + p[3];
-    coeff[1] = 3.0f * p[0] - 6.0f * p[1] + 3.0f * p[2];
-    coeff[2] = -3.0f * p[0] + 3.0f * p[1];
-    coeff[3] = p[0];
-    
-    std::vector<glm::vec3> points;
-    float length = 0;
-    for (float i = 0.0f, j = 0; i < 1.0f; i += 1.0f/150.0f, j++)
+    glm::vec3 ab = b - a;
+    float length2 = glm::dot(ab, ab);
+    float t = length2 > 0.0f ? glm::clamp(glm::dot(point - a, ab) / length2, 0.0f, 1.0f) : 0.0f;
+    glm::vec3 offset = a + ab * t - point;
+    return glm::dot(offset, offset);
+}
+
+// Writes the points after q[0] and returns how many.
+static int subdivide(const glm::vec3 q[4], float tolerance2, int depth, glm::vec3* points)
+{
+    // The curve lies inside the hull of its control points, so it is no
+    // further from the chord than the inner two are.
+    if (depth == 0 || (distanceToSegment2(q[1], q[0], q[3]) <= tolerance2
+                       && distanceToSegment2(q[2], q[0], q[3]) <= tolerance2))
     {
-        points.push_back(getPoint(i));
-        if (j != 0)
-        {
-            length += glm::length(points[j] - points[j - 1]);
-        }
+        points[0] = q[3];
+        return 1;
     }
     
-    this->length = length;
-    
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(),
-                 points.data(), GL_STATIC_DRAW);
+    // de Casteljau at t = 0.5.
+    glm::vec3 q01 = 0.5f * (q[0] + q[1]);
+    glm::vec3 q12 = 0.5f * (q[1] + q[2]);
+    glm::vec3 q23 = 0.5f * (q[2] + q[3]);
+    glm::vec3 q012 = 0.5f * (q01 + q12);
+    glm::vec3 q123 = 0.5f * (q12 + q23);
+    glm::vec3 middle = 0.5f * (q012 + q123);
+    glm::vec3 left[4] = { q[0], q01, q012, middle };
+    glm::vec3 right[4] = { middle, q123, q23, q[3] };
+    int count = subdivide(left, tolerance2, depth - 1, points);
+    return count + subdivide(right, tolerance2, depth - 1, points + count);
+}
+
+int BezierCurve::tessellate(float tolerance, int maxDepth, glm::vec3* points) const
+{
+    points[0] = p[0];
+    return 1 + subdivide(p.data(), tolerance * tolerance, maxDepth, points + 1);
 }
 
-glm::vec3 BezierCurve::getPoint(float t)
+float BezierCurve::arcLength(float t0, float t1) const
 {
-    return coeff[0] * pow(t, 3.0f) + coeff[1] * pow(t, 2.0f) + coeff[2] * t + coeff[3];
+    // The integral of the speed |B'(t)| over [t0, t1].
+    float half = 0.5f * (t1 - t0);
+    float middle = 0.5f * (t0 + t1);
+    float sum = 0.0f;
+    for (int i = 0; i < 5; i++)
+    {
+        sum += gaussWeights[i] * glm::length(getTangent(middle + half * gaussNodes[i]));
+    }
+    return half * sum;
+}
+
+float BezierCurve::arcLength(float t0, float t1, float estimate, int depth) const
+{
+    // Split until the halves agree with the whole; the speed is not a
+    // polynomial, and is least like one near cusps.
+    float middle = 0.5f * (t0 + t1);
+    float left = arcLength(t0, middle);
+    float right = arcLength(middle, t1);
+    if (depth == 0 || std::fabs(left + right - estimate) <= arcLengthTolerance * std::max(estimate, 1.0f))
+    {
+        return left + right;
+    }
+    return arcLength(t0, middle, left, depth - 1) + arcLength(middle, t1, right, depth - 1);
+}
+
+void BezierCurve::buildArcLengths()
+{
+    // The first try at every segment needs the speed at the nodes of the
+    // whole segment and of both halves. Those are evaluated in one batch;
+    // only segments where the halves and the whole disagree are split
+    // further, a few nodes at a time.
+    const int nodesPerSegment = 15;
+    std::vector<float> t(arcLengthSegments * nodesPerSegment);
+    for (int i = 0; i < arcLengthSegments; i++)
+    {
+        float t0 = (float)i / arcLengthSegments;
+        float t1 = (float)(i + 1) / arcLengthSegments;
+        float middle = 0.5f * (t0 + t1);
+        float* nodes = &t[i * nodesPerSegment];
+        for (int j = 0; j < 5; j++)
+        {
+            nodes[j] = middle + 0.5f * (t1 - t0) * gaussNodes[j];
+            nodes[5 + j] = 0.5f * (t0 + middle) + 0.5f * (middle - t0) * gaussNodes[j];
+            nodes[10 + j] = 0.5f * (middle + t1) + 0.5f * (t1 - middle) * gaussNodes[j];
+        }
+    }
+    // The speeds at the table's own parameters go in the same batch.
+    for (int i = 0; i <= arcLengthSegments; i++)
+    {
+        t.push_back((float)i / arcLengthSegments);
+    }
+    std::vector<float> speed(t.size());
+    evaluateCubicSpeeds(coeff.data(), t.data(), t.size(), speed.data());
+    arcSpeeds.assign(speed.end() - (arcLengthSegments + 1), speed.end());
+    
+    arcLengths.resize(arcLengthSegments + 1);
+    arcLengths[0] = 0.0f;
+    for (int i = 0; i < arcLengthSegments; i++)
+    {
+        float t0 = (float)i / arcLengthSegments;
+        float t1 = (float)(i + 1) / arcLengthSegments;
+        float middle = 0.5f * (t0 + t1);
+        const float* speeds = &speed[i * nodesPerSegment];
+        float whole = 0.0f;
+        float left = 0.0f;
+        float right = 0.0f;
+        for (int j = 0; j < 5; j++)
+        {
+            whole += gaussWeights[j] * speeds[j];
+            left += gaussWeights[j] * speeds[5 + j];
+            right += gaussWeights[j] * speeds[10 + j];
+        }
+        whole *= 0.5f * (t1 - t0);
+        left *= 0.5f * (middle - t0);
+        right *= 0.5f * (t1 - middle);
+        
+        float segment = left + right;
+        if (std::fabs(segment - whole) > arcLengthTolerance * std::max(whole, 1.0f))
+        {
+            segment = arcLength(t0, middle, left, 7) + arcLength(middle, t1, right, 7);
+        }
+        arcLengths[i + 1] = arcLengths[i] + segment;
+    }
+    length = arcLengths.back();
 }
 
-glm::vec3 BezierCurve::getTangent(float t)
+float BezierCurve::parameterAt(float distance) const
 {
-    return 3.0f * coeff[0] * pow(t, 2.0f) + 2.0f * coeff[1] * t + coeff[2];
+    if (distance <= 0.0f)
+    {
+        return 0.0f;
+    }
+    if (distance >= length)
+    {
+        return 1.0f;
+    }
+    
+    // The segment whose end is the first entry past distance.
+    int i = (int)(std::upper_bound(arcLengths.begin(), arcLengths.end(), distance) - arcLengths.begin()) - 1;
+    i = std::min(i, arcLengthSegments - 1);
+    float t0 = (float)i / arcLengthSegments;
+    float t1 = (float)(i + 1) / arcLengthSegments;
+    float segment = arcLengths[i + 1] - arcLengths[i];
+    if (segment <= 0.0f)
+    {
+        return t0;
+    }
+    
+    // t as a cubic in distance through both entries, with slopes dt/ds one
+    // over the speed there. Where the speed is small, near a cusp, the
+    // slopes are scaled down until the cubic can't overshoot (Fritsch and
+    // Carlson), so t still only grows along the segment.
+    float secant = (t1 - t0) / segment;
+    float m0 = arcSpeeds[i] > 0.0f ? 1.0f / arcSpeeds[i] : 3.0f * secant;
+    float m1 = arcSpeeds[i + 1] > 0.0f ? 1.0f / arcSpeeds[i + 1] : 3.0f * secant;
+    float alpha = m0 / secant;
+    float beta = m1 / secant;
+    float excess = alpha * alpha + beta * beta;
+    if (excess > 9.0f)
+    {
+        float scale = 3.0f / std::sqrt(excess);
+        m0 *= scale;
+        m1 *= scale;
+    }
+    float u = (distance - arcLengths[i]) / segment;
+    float u2 = u * u;
+    float u3 = u2 * u;
+    float t = (2.0f * u3 - 3.0f * u2 + 1.0f) * t0 + (u3 - 2.0f * u2 + u) * segment * m0
+              + (-2.0f * u3 + 3.0f * u2) * t1 + (u3 - u2) * segment * m1;
+    return glm::clamp(t, t0, t1);
 }
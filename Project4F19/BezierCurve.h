@@ -1,33 +1,45 @@
 #ifndef _BEZIERCURVE_H_
 #define _BEZIERCURVE_H_
 
-#ifdef __APPLE__
-#define GL_SILENCE_DEPRECATION
-#include <OpenGL/gl3.h>
-#else
-#include <GL/glew.h>
-#endif
+#include <glm/glm.hpp>
+#include <vector>
 
-#include "Node.h"
+#include "../Common/Bounds.h"
 
-class BezierCurve : public Node
+// One cubic segment of the track. Track draws every curve at once from its
+// own buffer, so a curve only answers questions about its shape.
+class BezierCurve
 {
 private:
-    glm::mat4 C;
     std::vector<glm::vec3> coeff;
-    GLuint vao;
-    GLuint vbo;
-    int indicesNum;
+    // Arc length from t = 0 up to each of arcLengthSegments + 1 evenly
+    // spaced parameters.
+    std::vector<float> arcLengths;
+    // The curve's speed at the same parameters, the slope of arc length, so
+    // parameterAt can interpolate between entries without integrating.
+    std::vector<float> arcSpeeds;
+    float arcLength(float t0, float t1) const;
+    float arcLength(float t0, float t1, float estimate, int depth) const;
+    void buildArcLengths();
 public:
     std::vector<glm::vec3> p;
+    // Arc length of the whole curve.
     float length;
+    // Around the control points, so around the whole curve too.
+    Bounds bounds;
     BezierCurve(std::vector<glm::vec3> p);
-    ~BezierCurve();
-    void draw(glm::mat4 C);
-    void update();
     void updateCoeff();
-    glm::vec3 getPoint(float t);
-    glm::vec3 getTangent(float t);
+    glm::vec3 getPoint(float t) const;
+    glm::vec3 getTangent(float t) const;
+    // Writes points along the curve from p[0] to p[3] such that the curve
+    // stays within tolerance of the line through them, and returns how
+    // many. Halves the curve at most maxDepth times, so writes at most
+    // 2^maxDepth + 1 points.
+    int tessellate(float tolerance, int maxDepth, glm::vec3* points) const;
+    // The parameter distance along the curve from p[0], by binary search in
+    // the arc length table and cubic Hermite interpolation between entries,
+    // so moving distance at a constant rate moves at a constant speed.
+    float parameterAt(float distance) const;
 };
 
 #endif
@@ -16,6 +16,7 @@
 #include <fstream>
 
 #include "shader.h"
+#include "../Common/ShaderProgram.h"
 
 class Node
 {
@@ -97,16 +97,17 @@ Skybox::~Skybox()
     glDeleteBuffers(1, &vbo);
     glDeleteVertexArrays(1, &vao);
     
-    glDeleteProgram(getShaderProgram());
+    ShaderProgram::release(getShaderProgram());
 }
 
 void Skybox::draw(glm::mat4 C)
 {
     glDepthFunc(GL_LEQUAL);  // change depth function so depth test passes when values are equal to depth buffer's content
-    glUseProgram(getShaderProgram());
+    ShaderProgram& shader = ShaderProgram::get(getShaderProgram());
+    shader.use();
     glm::mat4 view = glm::mat4(glm::mat3(Window::view)); // remove translation from the view matrix
-    glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "projection"), 1, GL_FALSE, glm::value_ptr(Window::projection));
+    shader.set("view", view);
+    shader.set("projection", Window::projection);
     
     glBindVertexArray(vao);
     glActiveTexture(GL_TEXTURE0);
@@ -9,6 +9,7 @@
 #endif
 
 #include "Node.h"
+#include "../Common/MeshCache.h"
 
 class Sphere : public Node
 {
@@ -1,132 +1,37 @@
 #include "Track.h"
 #include "Window.h"
 
+#include <cmath>
+
+// Control point markers are the 7.5 unit sphere scaled by 0.01.
+static const float markerRadius = 7.5f * 0.01f;
+
+// Curves are drawn to within half a pixel, halved at most 8 times, so each
+// takes at most 257 points.
+static const float curvePixels = 0.5f;
+static const int curveMaxDepth = 8;
+static const int curveSlotSize = (1 << curveMaxDepth) + 1;
+
 Track::Track()
 {
     std::string filename = "objs/sphere.obj";
-    std::ifstream objFile(filename); // The obj file we are reading.
-    std::vector<glm::vec3> points;
-    std::vector<glm::vec3> normals;
-    std::vector<glm::ivec3> faceIndices;
     
-    // Check whether the file can be opened.
-    if (objFile.is_open())
-    {
-        std::string line; // A line in the file.
-        
-        // Read lines from the file.
-        while (std::getline(objFile, line))
-        {
-            // Turn the line into a string stream for processing.
-            std::stringstream ss;
-            ss << line;
-            
-            // Read the first word of the line.
-            std::string label;
-            ss >> label;
-            
-            // If the line is about vertex (starting with a "v").
-            if (label == "v")
-            {
-                // Read the later three float numbers and use them as the
-                // coordinates.
-                glm::vec3 point;
-                ss >> point.x >> point.y >> point.z;
-                
-                // Process the point.
-                points.push_back(point);
-            }
-            else if (label == "vn") {
-                glm::vec3 normal;
-                ss >> normal.x >> normal.y >> normal.z;
-                
-                normals.push_back(normal);
-            }
-            else if (label == "f") {
-                glm::ivec3 indices;
-                std::string v1IndexStr, v2IndexStr, v3IndexStr;
-                
-                ss >> v1IndexStr >> v2IndexStr >> v3IndexStr;
-                indices.x = atoi(v1IndexStr.c_str()) - 1;
-                indices.y = atoi(v2IndexStr.c_str()) - 1;
-                indices.z = atoi(v3IndexStr.c_str()) - 1;
-                
-                faceIndices.push_back(indices);
-            }
-        }
-    }
-    else
-    {
-        std::cerr << "Can't open the file " << filename << std::endl;
-    }
-    
-    objFile.close();
+    // Normalized arrays, mapped from the binary cache when it is up to date.
+    // Faces share indices between points and normals.
+    MeshCache mesh;
+    mesh.load(filename, MESH_LAYOUT_SHARED_INDICES, 7.5f);
     
-    // Find center point of model
-    float minX = points[0].x, minY = points[0].y, minZ = points[0].z;
-    float maxX = points[0].x, maxY = points[0].y, maxZ = points[0].z;
-    
-    for (std::vector<glm::vec3>::size_type i = 1; i < points.size(); i++)
-    {
-        if (points[i].x < minX)
-        {
-            minX = points[i].x;
-        }
-        if (points[i].y < minY)
-        {
-            minY = points[i].y;
-        }
-        if (points[i].z < minZ)
-        {
-            minZ = points[i].z;
-        }
-        if (points[i].x > maxX)
-        {
-            maxX = points[i].x;
-        }
-        if (points[i].y > maxY)
-        {
-            maxY = points[i].y;
-        }
-        if (points[i].z > maxZ)
-        {
-            maxZ = points[i].z;
-        }
-    }
-    
-    // Find max distance away from center
-    float avgX = (maxX - minX) / 2, avgY = (maxY - minY) / 2, avgZ = (maxZ - minZ) / 2;
-    float maxDist;
-    
-    if (avgX >= avgY && avgX >= avgZ)
-    {
-        maxDist = avgX;
-    }
-    else if (avgY >= avgX && avgY >= avgZ)
-    {
-        maxDist = avgY;
-    }
-    else if (avgZ >= avgX && avgZ >= avgY)
-    {
-        maxDist = avgZ;
-    }
-    
-    // Normalizing scale
-    for (std::vector<glm::vec3>::size_type i = 0; i < points.size(); i++)
-    {
-        points[i].x -= (maxX + minX) / 2;
-        points[i].x *= 7.5f / maxDist;
-        points[i].y -= (maxY + minY) / 2;
-        points[i].y *= 7.5f / maxDist;
-        points[i].z -= (maxZ + minZ) / 2;
-        points[i].z *= 7.5f / maxDist;
-    }
-    
-    indicesNum = faceIndices.size() * 3;
+    indicesNum = mesh.indexCount();
     
     // Model matrix.
     C = glm::mat4(1.0f);
     
+    // Made by setCurves.
+    geometry = nullptr;
+    geometryVao = 0;
+    drawBase = 0;
+    drawStale = true;
+    
     // Generate a vertex array (VAO) and two vertex buffer objects (VBO).
     glGenVertexArrays(1, &vao);
     glGenBuffers(2, vbos);
@@ -135,21 +40,21 @@ Track::Track()
     glBindVertexArray(vao);
     
     glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(),
-                 points.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.positionCount(),
+                 mesh.positions(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
     
     glBindBuffer(GL_ARRAY_BUFFER, vbos[1]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * normals.size(),
-                 normals.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * mesh.normalCount(),
+                 mesh.normals(), GL_STATIC_DRAW);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
     
     glGenBuffers(1, &ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(glm::ivec3) * faceIndices.size(),
-                 faceIndices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned) * mesh.indexCount(),
+                 mesh.indices(), GL_STATIC_DRAW);
     
     // Unbind from the VBOs.
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -165,29 +70,60 @@ Track::~Track()
     glDeleteBuffers(2, vbos);
     glDeleteBuffers(1, &ebo);
     glDeleteVertexArrays(1, &vao);
+    delete geometry;
+    glDeleteVertexArrays(1, &geometryVao);
     
-    glDeleteProgram(getShaderProgram());
+    ShaderProgram::release(getShaderProgram());
 }
 
 void Track::draw(glm::mat4 C)
 {
     this->C = C;
+    ShaderProgram& shader = ShaderProgram::get(getShaderProgram());
+    
+    // World units per pixel at unit distance.
+    float pixelSize = 2.0f * std::tan(0.5f * (float)Window::fov) / std::max(Window::height, 1);
+    
     GLuint point = 0;
-    for (BezierCurve* curve: curves)
+    for (size_t i = 0; i < curves.size(); i++)
     {
-        curve->draw(C);
+        BezierCurve* curve = curves[i];
+        // The curve lies inside its control points, so if those are out of
+        // view so are the curve and its markers.
+        uint8_t visible = sphereInFrustum(Window::frustumPlanes, curve->bounds.center,
+                                          curve->bounds.radius + markerRadius);
+        if (visible != curveVisible[i])
+        {
+            curveVisible[i] = visible;
+            drawStale = true;
+        }
+        if (!visible)
+        {
+            point += 3;
+            continue;
+        }
+        
+        // Tolerance for the nearest the curve can be, past the near plane,
+        // rounded down to a power of two so it is only redone when the
+        // camera has moved a fair way.
+        float distance = std::max(glm::length(curve->bounds.center - Window::eye) - curve->bounds.radius, 1.0f);
+        float tolerance = std::exp2(std::floor(std::log2(curvePixels * pixelSize * distance)));
+        if (tolerance != curveTolerance[i])
+        {
+            tessellate((int)i, tolerance);
+        }
         
         // anchor point
         glm::mat4 model = glm::translate(curve->p[0]) * glm::scale(glm::vec3(0.01));
-        glUseProgram(getShaderProgram());
-        glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "model"), 1, GL_FALSE, glm::value_ptr(model));
+        shader.use();
+        shader.set("model", model);
         if (point == Window::selectedPoint)
         {
-            glUniform3fv(glGetUniformLocation(getShaderProgram(), "color"), 1, glm::value_ptr(glm::vec3(0.0, 0.0, 1.0)));
+            shader.set("color", glm::vec3(0.0, 0.0, 1.0));
         }
         else
         {
-            glUniform3fv(glGetUniformLocation(getShaderProgram(), "color"), 1, glm::value_ptr(glm::vec3(1.0, 0.0, 0.0)));
+            shader.set("color", glm::vec3(1.0, 0.0, 0.0));
         }
         point++;
         
@@ -197,15 +133,15 @@ void Track::draw(glm::mat4 C)
         
         // control point 1
         model = glm::translate(curve->p[1]) * glm::scale(glm::vec3(0.01));
-        glUseProgram(getShaderProgram());
-        glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "model"), 1, GL_FALSE, glm::value_ptr(model));
+        shader.use();
+        shader.set("model", model);
         if (point == Window::selectedPoint)
         {
-            glUniform3fv(glGetUniformLocation(getShaderProgram(), "color"), 1, glm::value_ptr(glm::vec3(0.0, 0.0, 1.0)));
+            shader.set("color", glm::vec3(0.0, 0.0, 1.0));
         }
         else
         {
-            glUniform3fv(glGetUniformLocation(getShaderProgram(), "color"), 1, glm::value_ptr(glm::vec3(0.0, 1.0, 0.0)));
+            shader.set("color", glm::vec3(0.0, 1.0, 0.0));
         }
         point++;
         
@@ -215,15 +151,15 @@ void Track::draw(glm::mat4 C)
         
         // control point 2
         model = glm::translate(curve->p[2]) * glm::scale(glm::vec3(0.01));
-        glUseProgram(getShaderProgram());
-        glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "model"), 1, GL_FALSE, glm::value_ptr(model));
+        shader.use();
+        shader.set("model", model);
         if (point == Window::selectedPoint)
         {
-            glUniform3fv(glGetUniformLocation(getShaderProgram(), "color"), 1, glm::value_ptr(glm::vec3(0.0, 0.0, 1.0)));
+            shader.set("color", glm::vec3(0.0, 0.0, 1.0));
         }
         else
         {
-            glUniform3fv(glGetUniformLocation(getShaderProgram(), "color"), 1, glm::value_ptr(glm::vec3(0.0, 1.0, 0.0)));
+            shader.set("color", glm::vec3(0.0, 1.0, 0.0));
         }
         point++;
         
@@ -231,14 +167,50 @@ void Track::draw(glm::mat4 C)
         glDrawElements(GL_TRIANGLES, indicesNum, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
     }
-    // control handle
-    glUseProgram(getShaderProgram());
-    glUniformMatrix4fv(glGetUniformLocation(getShaderProgram(), "model"), 1, GL_FALSE, glm::value_ptr(this->C));
-    glUniform3fv(glGetUniformLocation(getShaderProgram(), "color"), 1, glm::value_ptr(glm::vec3(0.5, 0.5, 0.0)));
+    // Edits and tessellation above are all in, so this frame's region is
+    // up to date.
+    GLint base = (GLint)(geometry->begin() / sizeof(glm::vec3));
+    if (drawStale)
+    {
+        drawFirst.clear();
+        drawCount.clear();
+        for (size_t i = 0; i < curves.size(); i++)
+        {
+            if (curveVisible[i])
+            {
+                drawFirst.push_back(base + curveFirst[i]);
+                drawCount.push_back(curveCount[i]);
+            }
+        }
+        drawBase = base;
+        drawStale = false;
+    }
+    else if (base != drawBase)
+    {
+        // Same strips, only the region moved.
+        for (GLint& start: drawFirst)
+        {
+            start += base - drawBase;
+        }
+        drawBase = base;
+    }
+    
+    glBindVertexArray(geometryVao);
+    if (!drawFirst.empty())
+    {
+        shader.use();
+        shader.set("model", this->C);
+        shader.set("color", glm::vec3(0));
+        glMultiDrawArrays(GL_LINE_STRIP, drawFirst.data(), drawCount.data(), (GLsizei)drawFirst.size());
+    }
     
-    glBindVertexArray(lineVao);
-    glDrawArrays(GL_LINES, 0, curves.size() * 2);
+    // control handle
+    shader.use();
+    shader.set("model", this->C);
+    shader.set("color", glm::vec3(0.5, 0.5, 0.0));
+    glDrawArrays(GL_LINES, base + lineFirst, curves.size() * 2);
     glBindVertexArray(0);
+    geometry->end();
 }
 
 void Track::update()
@@ -248,24 +220,34 @@ void Track::update()
 void Track::setCurves(std::vector<BezierCurve*> curves)
 {
     this->curves = curves;
-    std::vector<glm::vec3> points;
     
-    for (BezierCurve* curve: this->curves)
+    // Room for every curve at its finest; each is tessellated the first
+    // time it is drawn.
+    curveFirst.resize(this->curves.size());
+    curveCount.assign(this->curves.size(), 0);
+    curveTolerance.assign(this->curves.size(), 0.0f);
+    curveVisible.assign(this->curves.size(), 0);
+    drawFirst.reserve(this->curves.size());
+    drawCount.reserve(this->curves.size());
+    drawBase = 0;
+    drawStale = true;
+    for (size_t i = 0; i < this->curves.size(); i++)
     {
-        curve->setShaderProgram(getShaderProgram());
-        points.push_back(curve->p[1]);
-        points.push_back(curve->p[2]);
+        curveFirst[i] = (GLint)(i * curveSlotSize);
     }
-    std::rotate(points.rbegin(), points.rbegin() + 1, points.rend());
+    lineFirst = (GLint)(this->curves.size() * curveSlotSize);
     
-    glGenVertexArrays(1, &lineVao);
-    glGenBuffers(1, &lineVbo);
+    delete geometry;
+    geometry = new StreamBuffer(sizeof(glm::vec3) * (lineFirst + this->curves.size() * 2));
+    updateLines();
     
-    glBindVertexArray(lineVao);
+    if (!geometryVao)
+    {
+        glGenVertexArrays(1, &geometryVao);
+    }
+    glBindVertexArray(geometryVao);
     
-    glBindBuffer(GL_ARRAY_BUFFER, lineVbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(),
-                 points.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, geometry->id());
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
     
@@ -273,6 +255,27 @@ void Track::setCurves(std::vector<BezierCurve*> curves)
     glBindVertexArray(0);
 }
 
+void Track::tessellate(int index, float tolerance)
+{
+    glm::vec3 points[curveSlotSize];
+    curveCount[index] = curves[index]->tessellate(tolerance, curveMaxDepth, points);
+    curveTolerance[index] = tolerance;
+    drawStale = true;
+    geometry->write(sizeof(glm::vec3) * curveFirst[index], points, sizeof(glm::vec3) * curveCount[index]);
+}
+
+void Track::updateLines()
+{
+    std::vector<glm::vec3> points;
+    for (BezierCurve* curve: curves)
+    {
+        points.push_back(curve->p[1]);
+        points.push_back(curve->p[2]);
+    }
+    std::rotate(points.rbegin(), points.rbegin() + 1, points.rend());
+    geometry->write(sizeof(glm::vec3) * lineFirst, points.data(), sizeof(glm::vec3) * points.size());
+}
+
 void Track::movePoint(int num, glm::vec3 translate)
 {
     BezierCurve* curve1 = curves[num / 3];
@@ -314,18 +317,8 @@ void Track::movePoint(int num, glm::vec3 translate)
     }
     curve1->updateCoeff();
     curve2->updateCoeff();
-    
-    std::vector<glm::vec3> points;
-    
-    for (BezierCurve* curve: this->curves)
-    {
-        curve->setShaderProgram(getShaderProgram());
-        points.push_back(curve->p[1]);
-        points.push_back(curve->p[2]);
-    }
-    std::rotate(points.rbegin(), points.rbegin() + 1, points.rend());
-    
-    glBindBuffer(GL_ARRAY_BUFFER, lineVbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * points.size(),
-                 points.data(), GL_STATIC_DRAW);
+    // Only these two are tessellated again, the next time they are drawn.
+    curveTolerance[num / 3] = 0.0f;
+    curveTolerance[curveIndex] = 0.0f;
+    updateLines();
 }
@@ -8,7 +8,11 @@
 #include <GL/glew.h>
 #endif
 
+#include <cstdint>
+
 #include "Node.h"
+#include "../Common/MeshCache.h"
+#include "../Common/StreamBuffer.h"
 #include "BezierCurve.h"
 
 class Track : public Node
@@ -18,9 +22,27 @@ private:
     GLuint vao;
     GLuint vbos[2];
     GLuint ebo;
-    GLuint lineVao;
-    GLuint lineVbo;
     int indicesNum;
+    // Every curve's line strip, each in a slot of its own so it can be
+    // redone in place, then the control handles, all in one stream buffer.
+    // Curves are drawn together in one call.
+    StreamBuffer* geometry;
+    GLuint geometryVao;
+    std::vector<GLint> curveFirst;
+    std::vector<GLsizei> curveCount;
+    GLint lineFirst;
+    // Tolerance each curve was last tessellated to, 0 once it has changed.
+    std::vector<float> curveTolerance;
+    // The visible curves' strips as passed to glMultiDrawArrays, offset by
+    // drawBase into the stream buffer. Only refilled when a curve is
+    // tessellated again or comes into or out of view.
+    std::vector<uint8_t> curveVisible;
+    std::vector<GLint> drawFirst;
+    std::vector<GLsizei> drawCount;
+    GLint drawBase;
+    bool drawStale;
+    void tessellate(int index, float tolerance);
+    void updateLines();
 public:
     std::vector<BezierCurve*> curves;
     Track();
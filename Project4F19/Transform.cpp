@@ -7,7 +7,9 @@ Transform::Transform(glm::mat4 M, GLuint shaderProgram, GLuint id)
     this->setShaderProgram(shaderProgram);
     this->id = id;
     this->lastTime = glfwGetTime();
-    this->dist = 0;
+    this->curve = 0;
+    this->distance = 0;
+    this->parameter = 0;
 }
 
 Transform::~Transform()
@@ -45,7 +47,7 @@ void Transform::update()
         if (Window::isRider)
         {
             Window::eye = position;
-            Window::center = position + sphereTangent(deltaTime);
+            Window::center = position + sphereTangent();
             Window::view = glm::lookAt(Window::eye, Window::center, Window::up);
         }
     }
@@ -68,35 +70,47 @@ void Transform::addChild(Node* node)
 
 glm::vec3 Transform::spherePosition(float deltaTime)
 {
+    std::vector<BezierCurve*>& curves = Window::track->curves;
+    int count = (int)curves.size();
     float speed = 5.0f;
     if (Window::isVariableVel)
     {
-        float y = Window::track->curves[(int)dist]->getPoint(dist - (int)dist).y + 30;
+        float y = curves[curve]->getPoint(parameter).y + 30;
 
         speed = -0.5 * y + 20;
     }
     
-    float frameDistance = speed * deltaTime;
-    glm::vec3 position;
-    
-    if ((int)(frameDistance + dist) > (int)dist) // should go to next curve
+    // Distance is measured along the curves, so the sphere covers the same
+    // ground every second wherever it is.
+    distance += speed * deltaTime;
+    // A track with every point in one place has nowhere to go, and the
+    // loops below would never get past it.
+    float total = 0.0f;
+    for (BezierCurve* each: curves)
     {
-        frameDistance = frameDistance + dist - (int)(frameDistance + dist);
+        total += each->length;
     }
-    position = Window::track->curves[(int)dist]->getPoint(dist + (frameDistance / Window::track->curves[(int)dist]->length) - (int)dist);
-    
-    dist += frameDistance / Window::track->curves[(int)dist]->length;
-    if (dist >= Window::track->curves.size())
+    if (total <= 0.0f)
+    {
+        distance = 0.0f;
+        return curves[curve]->getPoint(parameter);
+    }
+    while (distance >= curves[curve]->length)
+    {
+        distance -= curves[curve]->length;
+        curve = (curve + 1) % count;
+    }
+    while (distance < 0)
     {
-        dist -= Window::track->curves.size();
+        curve = (curve + count - 1) % count;
+        distance += curves[curve]->length;
     }
     
-    return position;
+    parameter = curves[curve]->parameterAt(distance);
+    return curves[curve]->getPoint(parameter);
 }
 
-glm::vec3 Transform::sphereTangent(float deltaTime)
+glm::vec3 Transform::sphereTangent()
 {
-    float frameDistance = 5 * deltaTime;
-    glm::vec3 position = Window::track->curves[(int)dist]->getTangent(dist + (frameDistance / Window::track->curves[(int)dist]->length) - (int)dist);
-    return position;
+    return Window::track->curves[curve]->getTangent(parameter);
 }
@@ -15,7 +15,11 @@ private:
     glm::mat4 M;
     std::vector<Node*> children;
     GLuint id;
-    float dist;
+    // Where the sphere is on the track: a curve, the arc length along it,
+    // and the matching parameter.
+    int curve;
+    float distance;
+    float parameter;
     float lastTime;
 public:
     Transform(glm::mat4 M, GLuint shaderProgram = -1, GLuint id = -1);
@@ -23,8 +27,11 @@ public:
     void draw(glm::mat4 C);
     void update();
     void addChild(Node* node);
-    glm::vec3 spherePosition(float t);
-    glm::vec3 sphereTangent(float deltaTime);
+    // Moves the sphere along the track for deltaTime and returns where it
+    // is now.
+    glm::vec3 spherePosition(float deltaTime);
+    // Direction of travel where the sphere is.
+    glm::vec3 sphereTangent();
 };
 
 #endif
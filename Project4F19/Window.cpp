@@ -25,6 +25,8 @@ glm::vec3 Window::up(0, 1, 0); // The up direction of the camera.
 // View matrix, defined by eye, center and up.
 glm::mat4 Window::view = glm::lookAt(Window::eye, Window::center, Window::up);
 
+glm::vec4 Window::frustumPlanes[6];
+
 GLuint Window::uboMatrices;
 
 GLuint Window::selectedPoint = 0;
@@ -77,11 +79,9 @@ bool Window::initializeObjects()
 
     sphere->addChild(sphereGeo);
 
-    glUseProgram(sphere->getShaderProgram());
-    glUniform1i(glGetUniformLocation(sphere->getShaderProgram(), "skybox"), 0);
+    ShaderProgram::get(sphere->getShaderProgram()).set("skybox", 0);
     
-    glUseProgram(skybox->getShaderProgram());
-    glUniform1i(glGetUniformLocation(skybox->getShaderProgram(), "skybox"), 0);
+    ShaderProgram::get(skybox->getShaderProgram()).set("skybox", 0);
     
     glGenBuffers(1, &uboMatrices);
     
@@ -190,6 +190,10 @@ void Window::displayCallback(GLFWwindow* window)
     glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(view));
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
     
+    // From the matrices every frame, since the rider camera moves the view
+    // in update.
+    extractFrustumPlanes(projection * view, frustumPlanes);
+    
     world->draw(glm::mat4(1));
     
     skybox->draw(glm::mat4(1));
@@ -269,6 +273,7 @@ void Window::keyCallback(GLFWwindow* window, int key, int scancode, int action,
                 break;
             case GLFW_KEY_V:
                 isVariableVel = !isVariableVel;
+                break;
             default:
                 break;
         }
@@ -28,6 +28,7 @@
 #include "Skybox.h"
 #include "BezierCurve.h"
 #include "Track.h"
+#include "../Common/Frustum.h"
 
 struct Material {
     glm::vec3 ambient;
@@ -51,6 +52,7 @@ public:
     static bool leftButtonPressed;
     static glm::mat4 projection;
     static glm::mat4 view;
+    static glm::vec4 frustumPlanes[6];
     static GLuint uboMatrices;
     static double fov;
     static glm::vec3 eye, center, up;
@@ -0,0 +1,301 @@
+// Checks that Project 3's frame loop doesn't allocate once it has warmed
+// up, by counting every operator new. Build from Project3F19, with every
+// source there but main.cpp and Window.cpp, and run there, where shaders/
+// is:
+//
+//   g++ -std=c++17 -I. -o frameAllocationTest ../Tests/FrameAllocationTest.cpp [!mW]*.cpp
+//       ../Common/*.cpp -lGLEW -lEGL -lGL -lpthread
+//   EGL_PLATFORM=surfaceless LIBGL_ALWAYS_SOFTWARE=1 ./frameAllocationTest
+
+#include "HeadlessContext.h"
+#include "Transform.h"
+#include "Geometry.h"
+#include "BoundingSphere.h"
+#include "Scene.h"
+#include "SkinnedMesh.h"
+#include "OcclusionCuller.h"
+#include "../Common/Frustum.h"
+#include "../Common/JobSystem.h"
+#include "../Common/RenderQueue.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<bool> counting(false);
+static std::atomic<long> allocations(0);
+
+void* operator new(size_t size)
+{
+    if (counting.load(std::memory_order_relaxed))
+    {
+        allocations++;
+    }
+    void* memory = malloc(size ? size : 1);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+static const int width = 640;
+static const int height = 480;
+static const char* meshFile = "frameAllocationTest.obj";
+
+// A unit sphere, so every part has levels of detail to pick from.
+static void writeSphere(const char* filename)
+{
+    FILE* file = fopen(filename, "w");
+    const int rings = 12;
+    const int segments = 24;
+    for (int ring = 0; ring <= rings; ring++)
+    {
+        float theta = glm::pi<float>() * ring / rings;
+        for (int segment = 0; segment < segments; segment++)
+        {
+            float phi = 2.0f * glm::pi<float>() * segment / segments;
+            glm::vec3 point(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            fprintf(file, "v %f %f %f\nvn %f %f %f\n", point.x, point.y, point.z, point.x, point.y, point.z);
+        }
+    }
+    for (int ring = 0; ring < rings; ring++)
+    {
+        for (int segment = 0; segment < segments; segment++)
+        {
+            int a = ring * segments + segment + 1;
+            int b = ring * segments + (segment + 1) % segments + 1;
+            int c = a + segments;
+            int d = b + segments;
+            fprintf(file, "f %d//%d %d//%d %d//%d\n", a, a, c, c, b, b);
+            fprintf(file, "f %d//%d %d//%d %d//%d\n", b, b, c, c, d, d);
+        }
+    }
+    fclose(file);
+}
+
+// The robot army of Window::initializeObjects, every part the same mesh.
+static Transform* buildWorld(GLuint shaderProgram, Transform*& robot)
+{
+    Transform* world = new Transform(glm::mat4(1.0));
+    robot = new Transform(glm::mat4(1.0), shaderProgram, 1);
+    for (int i = 0; i < 10; i++)
+    {
+        for (int j = 0; j < 10; j++)
+        {
+            Transform* transform = new Transform(glm::translate(glm::vec3(50 * i, 0, 50 * j)));
+            transform->addChild(robot);
+            world->addChild(transform);
+        }
+    }
+    
+    Transform* boundingSphere = new Transform(glm::mat4(1.0), 0, 2);
+    Transform* body = new Transform(glm::mat4(1.0));
+    Transform* head = new Transform(glm::translate(glm::vec3(0, 11.25, 0)));
+    Transform* eye = new Transform(glm::translate(glm::vec3(2.5, -1, 6.5)) * glm::scale(glm::vec3(0.1)));
+    Transform* leftArm = new Transform(glm::translate(glm::vec3(11, 0, 0)), 0, 3);
+    Transform* rightArm = new Transform(glm::translate(glm::vec3(-11, 0, 0)), 0, 4);
+    Transform* leftLeg = new Transform(glm::translate(glm::vec3(4, -11.5, 0)), 0, 5);
+    Transform* rightLeg = new Transform(glm::translate(glm::vec3(-4, -11.5, 0)), 0, 6);
+    leftArm->setMoveDir(1);
+    rightArm->setMoveDir(-1);
+    leftLeg->setMoveDir(-1);
+    rightLeg->setMoveDir(1);
+    
+    Transform* parts[] = { boundingSphere, body, head, leftArm, rightArm, leftLeg, rightLeg };
+    for (Transform* part: parts)
+    {
+        robot->addChild(part);
+    }
+    head->addChild(eye);
+    
+    boundingSphere->addChild(new BoundingSphere(meshFile));
+    Geometry* geometry = new Geometry(meshFile);
+    for (Transform* part: parts)
+    {
+        if (part != boundingSphere)
+        {
+            part->addChild(geometry);
+        }
+    }
+    eye->addChild(geometry);
+    
+    world->updateBounds();
+    return world;
+}
+
+struct Renderer
+{
+    Transform* world;
+    Scene scene;
+    JobSystem jobs;
+    SkinnedMesh* skin;
+    OcclusionCuller occlusion;
+    RenderQueue queue;
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 eye;
+    
+    // What Window::displayCallback does, short of the window.
+    void drawFrame(double time, bool flat, bool skinning, bool occluding)
+    {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        DrawContext context;
+        context.viewProjection = projection * view;
+        extractFrustumPlanes(context.viewProjection, context.frustumPlanes);
+        context.eye = eye;
+        context.lodScale = height / (2.0f * std::tan(glm::radians(60.0f) / 2));
+        context.time = time;
+        context.timeOffset = 0.0f;
+        context.robotsReached = 0;
+        context.queue = &queue;
+        context.occlusion = occluding ? &occlusion : nullptr;
+        context.skin = skinning ? skin : nullptr;
+        context.visibleRobots = 0;
+        context.culledRobots = 0;
+        context.occludedRobots = 0;
+        context.recomputedMatrices = 0;
+        
+        queue.eye = eye;
+        if (flat)
+        {
+            context.recomputedMatrices = scene.update(time, &jobs);
+            scene.draw(context);
+        }
+        else
+        {
+            world->draw(glm::mat4(1.0), context, 0);
+        }
+        Geometry::queueInstances(queue);
+        if (context.skin)
+        {
+            skin->queueInstances(queue);
+        }
+        queue.submit(occluding);
+        if (occluding)
+        {
+            occlusion.beginDepth(projection * view);
+            queue.submit();
+            occlusion.endDepth();
+        }
+        glFinish();
+    }
+};
+
+int main()
+{
+    if (!createHeadlessContext(width, height))
+    {
+        return 1;
+    }
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LEQUAL);
+    writeSphere(meshFile);
+    
+    GLuint shaderProgram = LoadShaders("shaders/shader.vert", "shaders/shader.frag");
+    glUniformBlockBinding(shaderProgram, glGetUniformBlockIndex(shaderProgram, "Matrices"), 0);
+    GLuint skinnedProgram = LoadShaders("shaders/skinned.vert", "shaders/shader.frag");
+    glUniformBlockBinding(skinnedProgram, glGetUniformBlockIndex(skinnedProgram, "Matrices"), 0);
+    
+    Renderer renderer;
+    Transform* robot;
+    renderer.world = buildWorld(shaderProgram, robot);
+    renderer.scene.build(renderer.world);
+    renderer.skin = new SkinnedMesh(robot, skinnedProgram);
+    renderer.occlusion.resize(width, height);
+    renderer.eye = glm::vec3(225, 50, 225);
+    renderer.projection = glm::perspective(glm::radians(60.0), (double)width / height, 1.0, 1000.0);
+    renderer.view = glm::lookAt(renderer.eye, glm::vec3(0), glm::vec3(0, 1, 0));
+    
+    GLuint uboMatrices;
+    glGenBuffers(1, &uboMatrices);
+    glBindBuffer(GL_UNIFORM_BUFFER, uboMatrices);
+    glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), NULL, GL_STATIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(renderer.projection));
+    glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(renderer.view));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 0, uboMatrices, 0, 2 * sizeof(glm::mat4));
+    
+    struct Mode
+    {
+        const char* name;
+        bool flat;
+        bool skinning;
+        bool culling;
+        bool occluding;
+    };
+    const Mode modes[] = {
+        { "flat, skinned, culled, occlusion tested", true, true, true, true },
+        { "flat, instanced, culled", true, false, true, false },
+        { "flat, instanced", true, false, false, false },
+        { "recursive, culled", false, false, true, false },
+    };
+    const int warmUpFrames = 30;
+    const int countedFrames = 60;
+    int failures = 0;
+    double time = 0.0;
+    for (const Mode& mode: modes)
+    {
+        Transform::cullingOn = mode.culling;
+        for (int frame = 0; frame < warmUpFrames + countedFrames; frame++)
+        {
+            if (frame == warmUpFrames)
+            {
+                allocations = 0;
+                counting = true;
+            }
+            renderer.drawFrame(time, mode.flat, mode.skinning, mode.occluding);
+            time += 1.0 / 60.0;
+        }
+        counting = false;
+        
+        long counted = allocations.load();
+        printf("%s: %s, %ld allocations in %d frames\n", counted == 0 ? "ok" : "FAIL", mode.name, counted,
+               countedFrames);
+        failures += counted == 0 ? 0 : 1;
+    }
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+    {
+        printf("FAIL: GL error 0x%x\n", error);
+        failures++;
+    }
+    
+    glDeleteBuffers(1, &uboMatrices);
+    const char* suffixes[] = { "", ".welded.opt.meshbin", ".indexed.meshbin", ".indexed.opt.meshbin" };
+    for (const char* suffix: suffixes)
+    {
+        remove((std::string(meshFile) + suffix).c_str());
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#ifndef _HEADLESS_CONTEXT_H_
+#define _HEADLESS_CONTEXT_H_
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <iostream>
+
+// An OpenGL 3.3 core context with no window, through EGL, for tests that
+// run without a display (Mesa's llvmpipe with EGL_PLATFORM=surfaceless and
+// LIBGL_ALWAYS_SOFTWARE=1). A width by height pbuffer stands in for the
+// window's framebuffer.
+inline bool createHeadlessContext(int width, int height)
+{
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay)
+    {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (display == EGL_NO_DISPLAY)
+    {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor))
+    {
+        std::cerr << "Failed to initialize EGL" << std::endl;
+        return false;
+    }
+    
+    const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                                        EGL_DEPTH_SIZE, 24, EGL_NONE };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+    {
+        std::cerr << "No EGL config with a pbuffer" << std::endl;
+        return false;
+    }
+    
+    eglBindAPI(EGL_OPENGL_API);
+    const EGLint contextAttributes[] = { EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+                                         EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                         EGL_NONE };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (context == EGL_NO_CONTEXT || surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context))
+    {
+        std::cerr << "Failed to create an OpenGL 3.3 context" << std::endl;
+        return false;
+    }
+    
+    // glewInit looks for GLX, which an EGL context doesn't have.
+    glewExperimental = GL_TRUE;
+    if (glewContextInit() != GLEW_OK)
+    {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
+        return false;
+    }
+    // GLEW can leave an error from probing extensions.
+    glGetError();
+    return true;
+}
+
+#endif
@@ -0,0 +1,146 @@
+// Checks OcclusionCuller against a known occluder, headless. Build from
+// Project3F19 and run there, where shaders/ is:
+//
+//   g++ -std=c++17 -I. -o occlusionTest ../Tests/OcclusionTest.cpp OcclusionCuller.cpp shader.cpp
+//       ../Common/ShaderProgram.cpp ../Common/SphereCuller.cpp -lGLEW -lEGL -lGL
+//   EGL_PLATFORM=surfaceless LIBGL_ALWAYS_SOFTWARE=1 ./occlusionTest
+
+#include "HeadlessContext.h"
+#include "OcclusionCuller.h"
+
+#include <cstdio>
+
+// With an identity view projection, positions are normalized device
+// coordinates. The window is 30x30, so the pyramid's base is 15x15 and odd
+// all the way down.
+static const int windowSize = 30;
+
+static const char* occluderVertex =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "void main() { gl_Position = vec4(position, 1.0); }\n";
+static const char* occluderFragment =
+    "#version 330 core\n"
+    "void main() {}\n";
+
+static GLuint compile(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+struct Case
+{
+    const char* name;
+    glm::vec3 center;
+    float radius;
+    bool inFrustum;
+    bool occluded;
+};
+
+int main()
+{
+    if (!createHeadlessContext(windowSize, windowSize))
+    {
+        return 1;
+    }
+    glEnable(GL_DEPTH_TEST);
+    
+    // A wall at depth 0.5 over x from -1 to 0.6, which is base columns 0 to
+    // 11; columns 12 to 14 stay at the far plane.
+    GLuint program = glCreateProgram();
+    GLuint vertex = compile(GL_VERTEX_SHADER, occluderVertex);
+    GLuint fragment = compile(GL_FRAGMENT_SHADER, occluderFragment);
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    const glm::vec3 wall[6] = { glm::vec3(-1, -1, 0), glm::vec3(0.6f, -1, 0), glm::vec3(0.6f, 1, 0),
+                                glm::vec3(-1, -1, 0), glm::vec3(0.6f, 1, 0), glm::vec3(-1, 1, 0) };
+    GLuint vao, vbo;
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(wall), wall, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+    glBindVertexArray(0);
+    
+    const Case cases[] = {
+        { "behind the wall", glm::vec3(-0.5f, 0.0f, 0.8f), 0.05f, true, true },
+        { "in front of the wall", glm::vec3(-0.5f, 0.0f, -0.5f), 0.05f, true, false },
+        { "clear of the wall", glm::vec3(0.85f, 0.0f, 0.8f), 0.05f, true, false },
+        // Spans base columns 11 and 12, which level 1 splits across its
+        // texel 5 and the last texel, 6, that also covers columns 13 and 14.
+        { "over the wall's edge", glm::vec3(0.635f, 0.0f, 0.8f), 0.075f, true, false },
+        { "behind the wall, frustum culled", glm::vec3(-0.5f, 0.5f, 0.8f), 0.05f, false, false },
+    };
+    const size_t count = sizeof(cases) / sizeof(cases[0]);
+    SphereSet spheres;
+    std::vector<uint32_t> visible((count + 31) / 32, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        spheres.push(cases[i].center, cases[i].radius);
+        if (cases[i].inFrustum)
+        {
+            visible[i >> 5] |= 1u << (i & 31);
+        }
+    }
+    
+    OcclusionCuller culler;
+    culler.resize(windowSize, windowSize);
+    culler.beginDepth(glm::mat4(1.0f));
+    glUseProgram(program);
+    glBindVertexArray(vao);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    culler.endDepth();
+    
+    // Results come back a frame after the test is issued.
+    int failures = 0;
+    std::vector<uint32_t> occluded;
+    if (culler.test(glm::mat4(1.0f), spheres, visible, occluded) != 0)
+    {
+        printf("FAIL: results before any test finished\n");
+        failures++;
+    }
+    glFinish();
+    culler.test(glm::mat4(1.0f), spheres, visible, occluded);
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        bool hidden = isVisible(occluded, i);
+        bool passed = hidden == cases[i].occluded;
+        printf("%s: %s, %s\n", passed ? "ok" : "FAIL", cases[i].name, hidden ? "occluded" : "not occluded");
+        failures += passed ? 0 : 1;
+    }
+    
+    // Once the camera has moved the results may hide what is now in view.
+    glm::mat4 moved(1.0f);
+    moved[3][0] = 0.5f;
+    glFinish();
+    if (culler.test(moved, spheres, visible, occluded) != 0)
+    {
+        printf("FAIL: results kept after the camera moved\n");
+        failures++;
+    }
+    else
+    {
+        printf("ok: results dropped after the camera moved\n");
+    }
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR)
+    {
+        printf("FAIL: GL error 0x%x\n", error);
+        failures++;
+    }
+    
+    glDeleteBuffers(1, &vbo);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+// Checks that the flattened Scene culls the same robots as the recursive
+// Transform traversal after parts of the tree are moved. Nothing is drawn,
+// so no window or context is needed. Build from Project3F19, with every
+// source there but main.cpp and Window.cpp:
+//
+//   g++ -std=c++17 -I. -o sceneTest ../Tests/SceneTest.cpp [!mW]*.cpp ../Common/*.cpp
+//       -lGLEW -lGL -lpthread
+//   ./sceneTest
+
+#include "Scene.h"
+#include "Transform.h"
+#include "../Common/Frustum.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/transform.hpp>
+#include <cstdio>
+
+// Stands in for a robot part's mesh: only its bounds matter to culling.
+class Part : public Node
+{
+private:
+    Bounds bounds;
+public:
+    Part(const glm::vec3& extent)
+    {
+        glm::vec3 corners[2] = { -extent, extent };
+        bounds = computeBounds(corners, 2);
+    }
+    void draw(const glm::mat4& C, DrawContext& context, int lod) {}
+    Bounds getBounds() { return bounds; }
+};
+
+struct Counts
+{
+    int visible;
+    int culled;
+};
+
+static DrawContext makeContext(const glm::vec4 planes[6])
+{
+    DrawContext context = {};
+    for (int p = 0; p < 6; p++)
+    {
+        context.frustumPlanes[p] = planes[p];
+    }
+    context.eye = glm::vec3(0, 50, 300);
+    context.lodScale = 1.0f;
+    return context;
+}
+
+static Counts flatCounts(Scene& scene, const glm::vec4 planes[6], bool bvh)
+{
+    Scene::bvhOn = bvh;
+    scene.update();
+    DrawContext context = makeContext(planes);
+    scene.draw(context);
+    return { context.visibleRobots, context.culledRobots };
+}
+
+static Counts recursiveCounts(Transform* world, const glm::vec4 planes[6])
+{
+    DrawContext context = makeContext(planes);
+    world->draw(glm::mat4(1.0), context, 0);
+    return { context.visibleRobots, context.culledRobots };
+}
+
+static int check(const char* name, Scene& scene, Transform* world, const glm::vec4 planes[6], int visible)
+{
+    Counts expected = recursiveCounts(world, planes);
+    Counts list = flatCounts(scene, planes, false);
+    Counts bvh = flatCounts(scene, planes, true);
+    bool ok = expected.visible == visible && list.visible == visible && bvh.visible == visible
+              && list.culled == expected.culled && bvh.culled == expected.culled;
+    printf("%s: %s, %d visible (recursive %d, list %d, hierarchy %d)\n", ok ? "ok" : "FAIL", name, visible,
+           expected.visible, list.visible, bvh.visible);
+    return ok ? 0 : 1;
+}
+
+int main()
+{
+    // A 3 by 3 grid sharing one robot, all in front of the camera.
+    Transform* world = new Transform(glm::mat4(1.0));
+    Transform* robot = new Transform(glm::mat4(1.0), -1, 1);
+    Transform* body = new Transform(glm::mat4(1.0));
+    body->addChild(new Part(glm::vec3(7.5, 10, 5)));
+    robot->addChild(body);
+    Transform* cells[9];
+    for (int i = 0; i < 9; i++)
+    {
+        cells[i] = new Transform(glm::translate(glm::vec3(50 * (i % 3) - 50, 0, 50 * (i / 3) - 50)));
+        cells[i]->addChild(robot);
+        world->addChild(cells[i]);
+    }
+    world->updateBounds();
+
+    Scene scene;
+    scene.build(world);
+    Transform::cullingOn = true;
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0), 640.0 / 480.0, 1.0, 1000.0);
+    glm::mat4 view = glm::lookAt(glm::vec3(0, 50, 300), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+    glm::vec4 planes[6];
+    extractFrustumPlanes(projection * view, planes);
+
+    int failures = 0;
+    failures += check("as built", scene, world, planes, 9);
+
+    // Moving a robot's parent moves its sphere.
+    cells[4]->setMatrix(glm::translate(glm::vec3(5000, 0, 0)));
+    failures += check("one cell moved away", scene, world, planes, 8);
+    cells[4]->setMatrix(glm::mat4(1.0));
+    failures += check("cell moved back", scene, world, planes, 9);
+
+    // So does moving the robot itself, its M being part of its bounds.
+    robot->setMatrix(glm::translate(glm::vec3(5000, 0, 0)));
+    failures += check("robot moved away", scene, world, planes, 0);
+    robot->setMatrix(glm::mat4(1.0));
+    failures += check("robot moved back", scene, world, planes, 9);
+
+    return failures == 0 ? 0 : 1;
+}